@@ -0,0 +1,597 @@
+#ifndef __5STAGE_HPP__
+#define __5STAGE_HPP__
+
+#include<MIPS_Processor.hpp>
+#include<Scoreboard.hpp>
+#include<Pipeline.hpp>
+#include<map>
+#include<string>
+using namespace std;
+
+namespace FiveStage
+{
+
+struct IFIDData //basically the L2 latch, used to transfer values between IF and ID stage
+{
+	Instruction command;
+	bool isWorking = true;
+	int PC = 0;
+	void clear() {}
+};
+struct IFID : Latch<IFIDData>
+{
+	bool IDisStalling = false; //set by ID while it stalls, IF looks at it in the same cycle
+};
+
+struct IF
+{
+	public:
+	MIPS_Architecture *arch;
+	bool isWorking = true;
+	IFID *L2; //L2 latch
+	int address;
+	Instruction CurCommand; //the current command after reading the address
+	
+	IF(MIPS_Architecture *architecture, IFID *l2)
+	{
+		arch = architecture; L2 = l2; isWorking = true;
+	}
+	void run()
+	{
+		if(arch->outputFormat == 0)
+		cout << " |IF|=> ";
+		if(arch->fetchDone()) //out of commands, or out of fetches in a sampled window
+		{
+			L2->next.command = Instruction();
+			isWorking = false;
+			L2->next.isWorking = false;
+			return; //since we must be done with all the commands at this point
+		} 
+		if(L2->IDisStalling == false)
+		{
+			arch->PCcurr = arch->PCnext;
+			arch->PCnext++;
+			arch->countFetch();
+			arch->memoryStall += arch->caches.fetch(arch->PCcurr) - 1;
+			address = arch->PCcurr;
+			if(arch->outputFormat == 0)
+				cout << "Fetched Command No. " << arch->PCcurr;
+			L2->next.PC = arch->PCcurr;
+			L2->next.isWorking = true; //a branch stalled in ID may have let IF run past the end before it was taken
+			CurCommand = arch->program[address]; //updates to this address
+			L2->next.command = CurCommand; //updates the value in the L2 at the same time, but for the next time
+		}
+		else
+		{
+			if(arch->outputFormat == 0)
+				cout << "** ";
+		}
+	}
+};
+
+struct IDEXData //the L3 register lying between ID and EX
+{
+	int data[3] = {0};
+	int writeReg = -1;
+	int instructionType = OP_NOP;
+	bool branchEnd = false; //set when a branch leaves the program, so that EX can stop the pipeline
+	bool isWorking = true;
+	int PC = 0;
+	void clear()
+	{
+		instructionType = OP_NOP; //this would ensure that if instruction
+		branchEnd = false; // type does not get updated, then we won't run any new commands
+	}
+};
+struct IDEX : Latch<IDEXData> {};
+struct ID
+{
+	public:
+	bool isWorking = true;
+	bool isStalling = false;
+	MIPS_Architecture *arch;
+	IFID* L2;
+	IDEX *L3;
+	int r[3] = {-1, -1, -1}; //r[0] is the written to register, r[1] and r[2] are the using registers, they can be -1
+	int dataValues[3] = {0}; //to be passed onto the EX stage for computation. only 2 will be sent most of the time, but for sw instruction, the value of the register would be sent as the index=2 element
+	int instructionType = OP_NOP;
+	Instruction curCommand;
+	enum {NO_CONTROL, AFTER_JUMP, AFTER_BRANCH} afterControl = NO_CONTROL; //what the stalled stage is waiting on after a j, beq or bne
+	int checkforPC;
+	Scoreboard *DataHazards; //the position of a writer is the latch it has reached
+	ID(MIPS_Architecture *architecture, Scoreboard *hazards, IFID *ifid, IDEX *idex)
+	{
+		arch = architecture;
+		DataHazards = hazards;
+		L2 = ifid;
+		L3 = idex;
+	}
+	void stall()
+	{
+		if(arch->outputFormat == 0)
+			cout << "**";
+		isStalling = true;	//then we should stall this stage right now.
+		L2->IDisStalling = true;
+		L3->next.instructionType = OP_NOP; //sending null as instruction
+		return;				//in the stall stage, we will not do any updated to the L3 latch, 
+							//so the next values for the next stage will be the default blanks	
+	}
+	bool isHazard(int reg)
+	{
+		return DataHazards->has(reg) && DataHazards->position[reg] < 5;
+	}
+	void run()
+	{
+		if(!isStalling) //if it is stalling, then we do not update the current command and isWorking status
+		{
+			curCommand = L2->cur.command; //we get the command from the L2 flipflop between IF and ID
+			afterControl = NO_CONTROL;
+			isWorking = L2->cur.isWorking; 
+			checkforPC = L2->cur.PC; 
+			L3->next.PC = checkforPC;
+		}
+		if(isWorking == false)
+		{
+			L3->next.instructionType = OP_NOP;
+			L3->next.isWorking = false;
+		}
+		//on the basis of the commands we got, we can assign further
+		if(arch->outputFormat == 0)
+			cout << " |ID|=> ";
+		
+		if(curCommand.op == OP_NOP)
+			return;
+		else if(afterControl == AFTER_JUMP) //if the previous instruction was a jump, it will have been calculated by now so we can stop the stalling
+		{
+			L2->IDisStalling = false;
+			isStalling = false; 
+			return;
+		}
+		else if(afterControl == AFTER_BRANCH)
+		{
+			stall();
+			afterControl = AFTER_JUMP; //so that the next time we can stop the stalling
+			return;
+		}
+		instructionType = curCommand.op;
+		for (int i = 0; i < 3; i++)
+		{
+			r[i] = curCommand.r[i];
+		}
+		if(instructionType == OP_J) //then its a jump instruction, in which case we should jump to the address label, using the label
+		{
+			if(arch->outputFormat == 0)
+				cout << "jumped to instruction number " << curCommand.target;
+			arch->PCnext = curCommand.target; //and then we must introduce a stall after this stage so as to
+			//not let a wrong instruction go by.
+			//the above code ensures that arch->PCnext has been updated correctly.
+			if(arch->outputFormat == 0)
+				cout << "PC= " << checkforPC;
+			afterControl = AFTER_JUMP;
+			stall();
+			if(curCommand.target >= int(arch->program.size()))
+			{
+				L3->next.instructionType = OP_NOP;
+				L3->next.isWorking = false; //then we need to stop the execution here
+			}
+			return;
+		}
+
+		//Checking Dependencies first, for lw and sw r[1] is the base register of the address
+		if(isHazard(r[1]) || isHazard(r[2]) ||
+			((instructionType == OP_BEQ || instructionType == OP_BNE || instructionType == OP_SW) && isHazard(r[0])))
+		{
+			stall();		
+			return;
+		}
+		else 
+		{	
+			if(arch->outputFormat == 0)
+				cout << " decoded " << opcodeName(instructionType) << " ";
+			if(instructionType != OP_SW && instructionType != OP_BEQ && instructionType != OP_BNE)
+			{
+				DataHazards->set(r[0], 2);
+			}
+			L2->IDisStalling = false;
+			isStalling = false; 
+		}
+
+		if(instructionType == OP_BEQ || instructionType == OP_BNE) //doing the entire BEQ and BNE process in ID step itself, while introducing a bubble in the pipeline where nothing gets done
+		{
+			bool isEqual = (arch->registers[r[0]]  == arch->registers[r[1]]);
+			if((isEqual^(instructionType == OP_BNE)))
+			{
+				if(arch->outputFormat == 0)
+					cout << "branched to instruction number " << curCommand.target;
+				arch->PCnext = curCommand.target;
+				if(arch->outputFormat == 0)
+					cout << "PC= " << checkforPC;
+				afterControl = AFTER_BRANCH;
+				stall();
+				if(curCommand.target >= int(arch->program.size()))
+				{
+					L3->next.branchEnd = true;
+					// L3->next.isWorking = false; //then we need to stop the execution here
+				}
+				return;
+			}
+			else
+			{
+				if(arch->outputFormat == 0)
+					cout << "did not branch- bubbled ";
+				L3->next.instructionType = OP_NOP;
+				afterControl = AFTER_BRANCH;
+				
+				stall();
+				if(arch->PCnext >= int(arch->program.size()))
+				{
+					L3->next.branchEnd = true;
+				}
+			}
+			return;
+		}
+
+		int curInstruction = curCommand.type;
+		if(curInstruction == 0) //then r2 and r3 need to be added/subtracted/whatever
+		{
+			dataValues[0] = arch->registers[r[1]];
+			dataValues[1] = arch->registers[r[2]];
+		}
+		else if(curInstruction == 1)
+		{
+			dataValues[0] = arch->registers[r[1]];
+			dataValues[1] = curCommand.imm; //since this is an immediate and not a register
+		}
+		else if(curInstruction == 2)//for lw and sw to be written LATER
+		{ 
+			dataValues[0] = curCommand.imm; //the offset and base register were already decoded with the instruction
+			dataValues[1] = arch->registers[r[1]];
+			dataValues[2] = arch->registers[r[0]];
+			if(instructionType == OP_SW){
+				if(arch->outputFormat == 0)
+					cout << " passed " << dataValues[2] << " for sw ";	
+			}
+			if(instructionType == OP_LW){
+				if(arch->outputFormat == 0)
+					cout << "Passed" << " $"<< r[1] <<"for lw";
+			}	
+		}
+		if(!isStalling)
+			if(arch->outputFormat == 0)
+				cout << dataValues[0] << " and " << dataValues[1] << " "<<"PC="<< checkforPC;
+		UpdateL3();
+	}
+
+	void UpdateL3()
+	{
+		//on getting the updated values, we can run the code
+		for (int i = 0; i < 3; i++)
+			L3->next.data[i] = dataValues[i];
+		L3->next.instructionType = instructionType;
+		L3->next.writeReg = r[0];
+		
+	}
+};
+struct EXDMData //the latch between EX and DM
+{
+	int reg = -1;
+	int SWdata = 0;
+	int dataIn = 0;
+	int memWrite = 0;
+	bool isWorking = true;
+	int PC = 0;
+	void clear()
+	{
+		memWrite = -1;
+		reg = -1;
+	}
+};
+struct EXDM : Latch<EXDMData> {};
+struct EX
+{	
+	public:
+	bool isWorking = true; int swData;
+	MIPS_Architecture *arch; IDEX *L3; EXDM *L4;//The L3 and L4 Latchs
+	int iType = OP_NOP;
+	int dataValues[3] = {0};
+	int result = 0;
+	int r1; //register to be written into, this will not be used in this step but passed forward till the WriteBack stage where it will be written into
+	//now we decode the instruction from the instructions map
+	int checkforPC;
+	EX(MIPS_Architecture *architecture, IDEX *l3, EXDM *l4)
+	{
+		arch = architecture; L3 = l3; L4 = l4; //the latch reference and architecture reference is stored at initialization
+	}
+
+	void run()
+	{	
+		iType = L3->cur.instructionType;
+		isWorking = L3->cur.isWorking; 
+		if(arch->outputFormat == 0)
+			cout << " |EX|=> ";
+		checkforPC = L3->cur.PC;
+		L4->next.PC = checkforPC;
+		if(!isWorking)
+		{
+			L4->next.isWorking = false; //updated this
+			if(arch->outputFormat == 0)
+				cout << isWorking;
+		}
+		if(L3->cur.branchEnd)
+		{
+			L4->next.reg = -1; L4->next.dataIn = -1;
+			L3->next.isWorking = false;
+			if(arch->outputFormat == 0)
+				cout << "BranchEnd";
+			return;
+		}
+		if(iType == OP_NOP)
+		{
+			L4->next.reg = -1; L4->next.dataIn = -1;
+			return;
+		}
+		for (int i = 0; i < 3; i++)
+			dataValues[i] = L3->cur.data[i];
+		r1 = L3->cur.writeReg; 
+		
+		result = calc(); 
+		if(iType == OP_SW)
+		{
+			L4->next.SWdata = dataValues[2];
+		}
+		L4->next.reg = r1; L4->next.dataIn = result; 
+		L4->next.memWrite = (iType == OP_SW)? 1 : (iType == OP_LW) ? 0 : -1;
+		if(iType != OP_SW && iType != OP_LW){
+			if(arch->outputFormat == 0)
+				cout << " did " << opcodeName(iType) << " " << dataValues[0] << " " << dataValues[1] << " "<<"PC "<<checkforPC;}
+		else{
+			if(arch->outputFormat == 0)
+				cout<<"address"<<dataValues[0] << " + " << dataValues[1] << "calculated"; 
+		}
+	}
+
+	int calc()
+	{
+		switch(iType)
+		{
+		case OP_NOP:
+			return -1;
+		case OP_ADD: case OP_ADDI: case OP_LW: case OP_SW:
+			return dataValues[0] + dataValues[1];
+		case OP_SUB:
+			return dataValues[0] - dataValues[1];
+		case OP_MUL:
+			return dataValues[0] * dataValues[1];
+		case OP_AND: case OP_ANDI:
+			return (dataValues[0] & dataValues[1]);
+		case OP_OR: case OP_ORI:
+			return (dataValues[0] | dataValues[1]);
+		case OP_SRL:
+			return (dataValues[0] >> dataValues[1]);
+		case OP_SLL:
+			return (dataValues[0] << dataValues[1]);
+		default: //if slt
+			return (dataValues[0] < dataValues[1]); 
+		}
+	}
+
+};
+struct DMWBData
+{
+	int reg = -1;
+	int data = 0;
+	bool isWorking = true;
+	int PC = 0;
+	void clear()
+	{
+		reg = -1;    //on getting the updated value we can run the code
+		data = 0;
+	}
+};
+struct DMWB : Latch<DMWBData> {};
+struct DM
+{
+	public:
+	bool isWorking = true;
+	MIPS_Architecture *arch; EXDM *L4; DMWB *L5; //the references to architecture and the L4 Latch 
+	int reg;
+	int checkforPc;
+	int memWrite = 0;  //when memWrite is 1, then we write from register into the memory
+					//when memWrite is 0. then we read from memory into register, so it is passed onto the WB stage to do that
+					//when it is -1, then we skip this stage and move onto the Writeback stage
+	int swData;
+	int dataIn; 	//dataIn is an address if memWrite is 1 or 0, otherwise its value will be directly stored onto the register in WB stage
+	DM(MIPS_Architecture *architecture, EXDM *exdm, DMWB *dmwb)
+	{
+		arch = architecture; L4 = exdm; L5 = dmwb; //initialisation
+	}
+
+	void run()
+	{
+		isWorking = L4->cur.isWorking;
+		checkforPc = L4->cur.PC;
+		L5->next.PC = checkforPc;
+		if(!isWorking)
+		{
+			L5->next.isWorking = false;
+		}
+		reg = L4->cur.reg; memWrite = L4->cur.memWrite; dataIn = L4->cur.dataIn;
+		swData = L4->cur.SWdata;
+		if(arch->outputFormat == 0)
+			cout << " |DM|=> "; 
+		//updated all the values using the latch L4
+
+		if(reg == -1)
+		{
+			L5->next.reg = -1;
+			return; //nothing to do here
+		}
+
+		if(memWrite == 1)
+		{
+			//then we write into the memory
+			if(dataIn%4 != 0) 
+			{
+				cerr << endl << "<!---Error: Address not word aligned at PC= " << checkforPc << "---!>" << endl;
+				return;
+			}
+			arch->data.write((uint32_t)dataIn/4, swData); //storing into the register what we decoded from a register file back in the ID stage
+			arch->memoryStall += arch->caches.write((uint32_t)dataIn/4) - 1;
+			if(arch->outputFormat == 0)	
+				cout << " sent val " << swData << " into memory at " << dataIn<< "PC="<<checkforPc;
+			L5->next.data = -1; L5->next.reg = -1; //since we dont need to write anything onto the register, the reg is passed as -1
+		}
+		else
+		{
+			//we must read from the memory into the register, so
+			if(memWrite == 0)
+			{
+				if(dataIn%4 != 0) 
+				{
+					cerr << endl << "<!---Error: Address not word aligned at PC= " << checkforPc << "---!>" << endl;
+					return;
+				}
+				arch->memoryStall += arch->caches.read((uint32_t)dataIn/4) - 1;
+				dataIn = arch->data.read((uint32_t)dataIn/4); 
+				if(arch->outputFormat == 0)
+					cout<< "sending value" << " " <<dataIn <<" "<<"from Memory to  register" <<" $"<<reg<<" "<<"PC="<<checkforPc;
+			}
+			//if memWrite is instead -1, then we simply pass on the value of dataIn directly.
+			L5->next.reg = reg;
+			L5->next.data = dataIn; 
+		}
+	}
+
+};
+struct WB{
+	public:
+	bool isWorking = true;
+	int r2;
+	int checkForPC;
+	int new_data;
+	MIPS_Architecture *arch;
+	DMWB* L5;
+	WB(MIPS_Architecture *a,DMWB *dmwb){
+		arch = a;
+		L5 = dmwb;
+	}
+	void run(){
+		isWorking = L5->cur.isWorking;
+		r2 = L5->cur.reg;
+		new_data  = L5->cur.data;
+		checkForPC = L5->cur.PC;
+		if(arch->outputFormat == 0)
+			cout << " |WB|=> ";
+		if(r2 != -1)
+		{
+			arch->registers[r2] = new_data;
+			if(arch->outputFormat == 0)
+				cout << "wrote " << new_data << " into reg $" << r2 << " "<<"currPC"<<L5->cur.PC;
+		}	
+	}
+};
+
+
+
+//the 5 stage pipeline: the scoreboard its stages share, its latches, then its stages in the order they run in a cycle
+//along with the latches they connect
+using Pipeline5 = Pipeline<Scoreboard, Latches<IFID, IDEX, EXDM, DMWB>,
+	Connect<WB, 3>, //First half Cycle
+	Connect<ID, 0, 1>, //Second Half Cycle, Decode running before IF so it can detect stalls and make IF stall
+	Connect<IF, 0>,
+	Connect<EX, 1, 2>,
+	Connect<DM, 2, 3>>;
+
+//the pipeline running on arch, everything a simulation changes is in here or in arch so simulators can run side by side
+struct Simulator
+{
+	MIPS_Architecture *arch;
+	Pipeline5 pipeline;
+
+	Simulator(MIPS_Architecture *architecture) : arch(architecture), pipeline(architecture) {}
+
+	//starts over on program, reusing the memory of arch (see MIPS_Architecture::reset)
+	void reset(const MIPS_Architecture &program)
+	{
+		arch->reset(program);
+		pipeline.reset();
+	}
+
+	//runs the pipeline from the current state of arch until it drains and returns the number of cycles it took
+	int run()
+	{
+		pipeline.reset(); //left over from an earlier run
+		Scoreboard &DataHazards = pipeline.state;
+		int clockCycles = 0;
+		DM &DataMemory = pipeline.stage<4>();
+
+		while(DataMemory.isWorking)
+		{
+			pipeline.cycle(); //runs the stages and then updates the intermittent latches
+			clockCycles++;
+			arch->timeFetches(clockCycles);
+			if(arch->outputFormat != 2)
+			{
+				arch->printRegisters(clockCycles);
+				if(DataMemory.memWrite == 1)
+				{
+					std::cout << 1 << " " << DataMemory.dataIn/4 << " " << DataMemory.swData;
+				}
+				else
+				{
+					std::cout << 0;
+				}
+			}
+			if(arch->trace)
+				arch->trace->cycle(arch->registers, DataMemory.memWrite == 1, DataMemory.dataIn/4, DataMemory.swData);
+			if(arch->outputFormat == 0) 
+			{	
+				std::cout << " dataHazards are : ";
+				for(int reg = 0; reg < 32; reg++)
+				{	
+					if(DataHazards.has(reg))
+						std::cout << "$" << reg << " " << DataHazards.position[reg] << ", ";
+				}
+			}
+			
+			DataHazards.age(6); //updating the hazards
+
+			//cout << endl << " at clockCycles " << clockCycles << endl;
+			if(arch->outputFormat != 2)
+				std::cout << endl;
+			clockCycles += arch->waitForMemory(clockCycles); //a cache miss holds up the whole pipeline
+		}
+		return clockCycles;
+	}
+};
+
+//runs the pipeline once on arch, see Simulator::run
+int RunPipeline(MIPS_Architecture *arch)
+{
+	Simulator simulator(arch);
+	return simulator.run();
+}
+
+void ExecutePipelined(MIPS_Architecture *arch)
+	{
+		if (arch->decodeError != arch->SUCCESS)
+		{
+			arch->handleExit(arch->decodeError, 0);
+			return;
+		} //a command could not be decoded
+		if ((long long)arch->commands.size() >= arch->addressLimit / 4)
+		{
+			arch->handleExit(arch->MEMORY_ERROR, 0);
+			return;
+		} //memory error
+
+		//registers[registerMap["$sp"]] = (4 * commands.size()); //initializes position of sp. assumes that all the commands are also stored in data and so sp needs to be here
+		//the above is optional, but since none of the testcases utilize it, it has been commented out
+		int clockCycles = RunPipeline(arch);
+		arch->handleExit(arch->SUCCESS, clockCycles);
+
+	}
+
+} //namespace FiveStage
+
+#endif
@@ -0,0 +1,927 @@
+#ifndef __79STAGE_HPP__
+#define __79STAGE_HPP__
+
+#include<MIPS_Processor.hpp>
+#include<Scoreboard.hpp>
+#include<Pipeline.hpp>
+#include<map>
+#include<string>
+#include<set>
+#include<vector>
+#include<iostream>
+
+using namespace std;
+
+namespace SevenNineStage
+{
+#define pint pair<int,int>
+//what the stages share besides the latches
+struct State
+{
+	Scoreboard DataHazards; //the position of a writer is the latch it has reached, its kind is 2 for a load and 0 otherwise
+	bool jumpStall = false;
+	int branchStall = 0;
+	int stallNumber = 0;
+	set<int> pcs;
+
+	void setJumpStall()
+	{
+		if(jumpStall)
+		{
+			branchStall = 0;
+			jumpStall = false;
+		}
+		
+	}
+};
+struct IFIDData //basically the L2 latch, used to transfer values between IF and ID stage
+{
+	Instruction command;
+	int PC = 0;
+	void clear()
+	{
+		PC = 0;
+		command = Instruction();
+	}
+};
+struct IFID : Latch<IFIDData> {};
+
+struct IF0
+{
+	MIPS_Architecture *arch;
+	State *state;
+	IFID *LIF;
+	IF0(MIPS_Architecture *mips, State *shared, IFID *lif)
+	{
+		state = shared;
+		arch = mips;
+		LIF = lif;
+	}
+
+	void run()
+	{
+		//checks if we are out of instructions
+		if(arch->outputFormat == 0)
+			cout << "|IF0|=>";
+
+		//checks if we are supposed to stall
+		if(state->stallNumber > 0)
+		{
+			//then we are supposed to stall and effectively do nothing
+			if(!arch->outputFormat)
+				cout << "**";
+			
+			return;
+		}
+		if(state->branchStall > 0)
+		{
+			if(!arch->outputFormat)
+				cout << "**";
+			return;
+		}
+		if(arch->fetchDone()) //out of commands, or out of fetches in a sampled window
+		{
+			if(!arch->outputFormat)
+				cout << "done";
+			return;
+		}
+		arch->PCcurr = arch->PCnext; arch->PCnext++;
+		arch->countFetch(); //fetch is stalled behind every branch, so nothing fetched is ever squashed
+		arch->memoryStall += arch->caches.fetch(arch->PCcurr) - 1;
+		if(arch->outputFormat==0)
+			cout << "fetched: " << arch->PCcurr;
+		state->pcs.insert(arch->PCcurr); //inserted the pc into the set
+		//else we will work
+		//then we check if the current instruction is a branch
+		LIF->next.PC = arch->PCcurr;
+		LIF->next.command = arch->program[arch->PCcurr];
+		if(LIF->next.command.type == 3)
+		{
+			//then we need to stall the pipeline
+			state->branchStall = 1; //so the next IF instruction gets stalled
+			//and pass the commands forward as well
+		}
+	}
+};
+
+struct IF1
+{
+	MIPS_Architecture *arch;
+	State *state;
+	IFID *LIF, *L2;
+	IF1(MIPS_Architecture *mips, State *shared, IFID *lif, IFID *l2)
+	{
+		state = shared;
+		arch = mips;
+		LIF = lif;
+		L2 = l2;
+	}
+
+	void run()
+	{
+		if(arch->outputFormat==0)
+			cout << "|IF1|=>";
+
+		if(state->stallNumber > 1)
+		{
+			//then we are supposed to stall and effectively do nothing
+			if(!arch->outputFormat)
+				cout << "**";
+			LIF->next.PC = LIF->cur.PC;
+			LIF->next.command = LIF->cur.command;			
+			return;
+		}
+		if(state->branchStall > 1)
+		{
+			if(!arch->outputFormat)
+				cout << "**";
+			LIF->next.PC = LIF->cur.PC;
+			LIF->next.command = LIF->cur.command;		
+			return;
+		}
+		//else we will work
+		
+		L2->next.command = LIF->cur.command;
+		if(LIF->cur.command.op == OP_NOP)
+		{
+			//then actually it hasnt been passed a command yet, so we just return
+			return;
+		}
+		L2->next.PC = LIF->cur.PC;
+		if(arch->outputFormat==0)
+			cout << "fetched1 " << LIF->cur.PC;
+		if(LIF->cur.command.type == 3)
+		{
+			state->branchStall = 2; //so the next IF1 instruction gets stalled as well.
+		}
+	} 
+};
+
+struct IDIDData //the  latch lying between the latch lying between ID0 and ID1
+{
+	Instruction command;
+	int PC = 0;
+	void clear()
+	{
+		command = Instruction(); //this would ensure that if instruction
+		// type does not get updated, then we won't run any new commands
+	}
+};
+struct IDID : Latch<IDIDData> {};
+
+struct ID0
+{
+	MIPS_Architecture *arch;
+	State *state;
+	IFID *L2; IDID *L3;
+	//ID0 will be responsible for decoding the instruction
+	ID0(MIPS_Architecture *mips, State *shared, IFID *l2, IDID *l3)
+	{
+		state = shared;
+		arch = mips;
+		L2 = l2;
+		L3 = l3;
+	}
+	void run()
+	{
+		if(arch->outputFormat==0)
+			cout << "|ID0|=>";
+		if(state->stallNumber > 2)
+		{
+			//then we are supposed to stall and effectively do nothing
+			if(!arch->outputFormat)
+				cout << "**";
+			L2->next.PC = L2->cur.PC;
+			L2->next.command = L2->cur.command;
+			return;
+		}
+		if(state->branchStall > 2)
+		{
+			//then we are supposed to stall and effectively do nothing
+			if(!arch->outputFormat)
+				cout << "**";
+			L2->next.PC = L2->cur.PC;
+			L2->next.command = L2->cur.command;
+			return;
+		}
+		//else we will work
+		L3->next.command = L2->cur.command;
+		if(L2->cur.command.op == OP_NOP)
+		{ 	//we haven't been passed a command yet, so we just return. This is basically a no-op
+			return;
+		}
+		L3->next.PC = L2->cur.PC;
+		if(L2->cur.command.type == 3)
+		{
+			//then we need to stall the pipeline
+			state->branchStall = 3; //so the next ID0 instruction gets stalled as well.
+			L2->cur.command = Instruction();
+			//and pass the commands forward as well
+		}
+	}
+};
+
+struct IDRRData
+{
+	Instruction command; //lw and sw carry their decoded offset in imm
+	int PC = -1;
+	void clear()
+	{
+		command = Instruction();
+	}
+};
+struct IDRR : Latch<IDRRData> {};
+
+struct ID1
+{
+	MIPS_Architecture *arch;
+	State *state;
+	IDID *LID; 	IDRR *L4; 
+	vector<int> InstructionsLeft = vector<int>(4,OP_NOP); //stores what type of instructions have previously left the ID1 stage
+	//useful for determining if a 9 stage instruction that left before will clash with the current instruction  at the writeback s
+	//stage if they both use the writeback port
+	Instruction curCommand; int instructionType;
+	//ID0 will be responsible for decoding the instruction
+	ID1(MIPS_Architecture *mips, State *shared, IDID *lid, IDRR *l4)
+	{
+		state = shared;
+		arch = mips;
+		LID = lid;
+		L4 = l4;
+	}
+	bool checkForFIFOstall(bool willWrite)
+	{
+		if(InstructionsLeft[1] == OP_LW || InstructionsLeft[1] == OP_SW)
+		{
+			//then we need to stall regardless of whether the current instruction will write or not
+			return true;
+		}
+		if(willWrite)
+		{
+			if(InstructionsLeft[2] == OP_LW)
+			{
+				//then we need to stall
+				return true;
+			}
+			else
+			{
+				return false; //we don't need to stall
+			}
+		}
+		else
+		{
+			return false; //we don't need to stall since we will not write and an instruction 2 stage before can use writeback stage
+		}
+	}
+	bool isHazard(int reg)
+	{
+		return state->DataHazards.has(reg) && state->DataHazards.position[reg] - state->DataHazards.kind[reg] <= 5;
+	}
+	void UpdateInstructionsLeft()
+	{
+		for (int i = InstructionsLeft.size() - 2; i >= 0; i--)
+		{
+			InstructionsLeft[i+1] = InstructionsLeft[i]; //shift everything to the right
+		}
+		InstructionsLeft[0] = OP_NOP;
+	}
+	void run()
+	{
+		if(arch->outputFormat==0)
+			cout << "|ID1|=>";
+		//first we check the stall condition
+		UpdateInstructionsLeft(); //moving all the previous instructions to the right
+		if(state->stallNumber > 3)
+		{
+			//then we are supposed to stall and effectively do nothing
+			if(!arch->outputFormat)
+				cout << "**";
+			LID->next.PC = LID->cur.PC;
+			LID->next.command = LID->cur.command;
+			return;
+		}
+		
+		else if(state->branchStall > 3)
+		{
+			//then we are supposed to stall and effectively do nothing
+			if(!arch->outputFormat)
+				cout << "**";
+			LID->next.PC = LID->cur.PC;
+			LID->next.command = LID->cur.command;
+			return;
+		}
+		else
+		{
+			curCommand = LID->cur.command;
+		}
+		//else we will work
+		//we will first check if the instruction is a branch, sent from IF1
+		if(curCommand.op == OP_NOP)
+		{
+			L4->next.command = curCommand; //passing a no-op
+			return;
+		}
+		instructionType = curCommand.op;
+		if(instructionType == OP_J)
+		{
+			//then we needa jump to
+			arch->PCnext = curCommand.target; //this moves the pc
+			LID->cur.command = Instruction();
+			//also we need to set the new PC now, and also change branchstall.
+			state->jumpStall = true;
+			//the jump has no registers and does not use the writeback port, so it never stalls here.
+			//it is still passed on so that its pc leaves the pipeline at the writeback stage
+			state->stallNumber = 0;
+		}
+		else if (instructionType == OP_LW || instructionType == OP_SW)
+		{
+			//the address was already decoded, r[1] is the register and imm the offset
+			//now we check for data hazards
+			bool shouldStall = (instructionType == OP_SW && isHazard(curCommand.r[0]));
+			shouldStall = shouldStall || isHazard(curCommand.r[1]);
+			if(shouldStall)
+			{
+				//then we need to stall the pipeline
+				state->stallNumber = 3; //so the next ID1 instruction gets stalled as well. //then we stall.
+				LID->next.command = LID->cur.command;
+				LID->next.PC = LID->cur.PC;
+				L4->next.PC = LID->cur.PC;
+				//and do nothing else
+				//and pass the commands forward as well
+				return; //we return as there is nothing to do. the next stages automatically recieve a no-op
+			}
+			else state->stallNumber = 0; //if we're not stalling
+			InstructionsLeft[0] = instructionType; //updated with the current instruction.
+		}
+		else if(instructionType == OP_BEQ || instructionType == OP_BNE)
+		{
+			
+			bool shouldStall = isHazard(curCommand.r[0]) || isHazard(curCommand.r[1]); //both registers are compared
+			shouldStall = (shouldStall || checkForFIFOstall(false));
+			if(shouldStall)
+			{
+				//then we need to stall the pipeline
+				state->stallNumber = 3; //so the next ID1 instruction gets stalled as well. //then we stall.
+				LID->next.command = LID->cur.command;
+				LID->next.PC = LID->cur.PC;
+				//and do nothing else //and pass the commands forward as well
+				return; //we return as there is nothing to do. the next stages automatically recieve a no-op
+			}
+			//then we need to stall the pipeline
+			state->branchStall = 4; //so the next ID1 instruction gets stalled as well.
+			state->stallNumber = 0;
+			LID->cur.command = Instruction();
+			InstructionsLeft[0] = instructionType; //updated with the current instruction.
+			//and do nothing else
+			//and pass the commands forward as well	
+		}
+		else
+		{
+			bool shouldStall = false;
+			//either it is num 0 or num 1 type instruction, both of which have the first register as a dataHazard.
+			if(curCommand.type == 0) 	//check dependency for the second register
+				if(isHazard(curCommand.r[2]))
+					shouldStall = true;
+			
+			if(isHazard(curCommand.r[1]))
+				shouldStall = true;
+			
+			if(checkForFIFOstall(true))
+				shouldStall = true;
+			
+			if(shouldStall)
+			{
+				//then we need to stall the pipeline
+				state->stallNumber = 3; //so the next ID1 instruction gets stalled as well. //then we stall.
+				LID->next.command = LID->cur.command;
+				LID->next.PC = LID->cur.PC;
+				//and do nothing else
+				//and pass the commands forward as well
+				return; //we return as there is nothing to do. the next stages automatically recieve a no-op
+			}
+			//otherwise we anyway have to check the dependency for the first register
+			state->stallNumber = 0; //reset the stall number otherwise
+			
+		}
+		if(instructionType != OP_SW && instructionType != OP_BEQ && instructionType != OP_BNE && instructionType != OP_J)
+		{
+			state->DataHazards.set(curCommand.r[0], 3, instructionType == OP_LW ? 2 : 0); //the datahazard is inserted here
+		}
+		L4->next.PC = LID->cur.PC; L4->next.command = curCommand; InstructionsLeft[0] = instructionType; //updated with the current instruction.
+	}
+};
+struct RREXData //the latch lying between RR and EX
+{
+	int data[3] = {0};
+	Instruction command;
+	int writeReg = -1;
+	int PC = -1;
+	void clear()
+	{
+		command = Instruction(); //this would ensure that if instruction
+		// type does not get updated, then we won't run any new commands
+	}
+};
+struct RREX : Latch<RREXData>
+{
+	RREX()
+	{
+		next.PC = 0;
+	}
+};
+
+
+struct RR
+{
+	MIPS_Architecture *arch;
+	State *state;
+	IDRR *L4; RREX *L5r, *L5i;
+	int regVal[3] = {0}; int nextOffset = 0;
+	int writeReg = -1;
+	Instruction curCommand;
+	//RR is responsible for reading the register values and passing them to EX for working
+	RR(MIPS_Architecture *mips, State *shared, IDRR *l4, RREX *l5a, RREX *l5b)
+	{
+		state = shared;
+		arch = mips;
+		L4 = l4;
+		L5r = l5a;
+		L5i = l5b;
+	}
+	void run()
+	{
+		if(arch->outputFormat==0)
+			cout << "|RR|=>";
+		if(state->stallNumber > 4)
+		{
+			//then we are supposed to stall and effectively do nothing
+			if(!arch->outputFormat)
+				cout << "**";
+			return;
+		}
+		else if(state->branchStall > 4)
+		{
+			//then we are supposed to stall and effectively do nothing
+			if(!arch->outputFormat)
+				cout << "**";
+			return;
+		}
+		else
+		{
+			curCommand = L4->cur.command;
+		}
+		//else we will work
+		if(curCommand.op == OP_NOP)
+		{
+
+			// L4->next.command = curCommand; //passing a no-op
+			return;
+		}
+		
+		regVal[0] = (curCommand.r[1] >= 0) ? arch->registers[curCommand.r[1]] : 0;
+		if(curCommand.type == 2 || curCommand.op == OP_J)
+			regVal[1] = 0;
+		else if(curCommand.type == 0)
+			regVal[1] = arch->registers[curCommand.r[2]];
+		else if(curCommand.type == 1)
+			regVal[1] = curCommand.imm;
+		// else
+		// 	regVal[1] = arch->registers[arch->registerMap[curCommand[3]]]; //getting its value normally
+
+		writeReg = curCommand.r[0]; 		
+		if(curCommand.type == 2)
+		{
+			//then we need to take the 9 stage pipeline path
+			if(!arch->outputFormat)
+				cout << "Itype ";
+			nextOffset = curCommand.imm;
+			regVal[1] = nextOffset; 
+			regVal[2] = arch->registers[curCommand.r[0]]; //getting the value of the register
+			// L5r->next.command = {}; //passing a no-op
+			L5i->next.PC = L4->cur.PC;
+			L5i->next.writeReg = writeReg;
+			for (int i = 0; i < 3; i++)
+				L5i->next.data[i] = regVal[i]; //passing the data to ALU of the i type (9 stage) instruction
+			L5i->next.command = curCommand; 
+			if(arch->outputFormat == 0)
+			cout << opcodeName(curCommand.op) << " " << nextOffset << "+" << regVal[0] << "for $" << writeReg <<":" << regVal[2] ; // << "data-" <<  << " ";
+		}
+		else
+		{
+			//otherwise we need to take the the 7 stage pipeline path
+			// L5i->next.command = {};
+			L5r->next.PC = L4->cur.PC;
+			L5r->next.command = curCommand;
+			L5r->next.writeReg = writeReg;
+			for (int i = 0; i < 3; i++)
+				L5r->next.data[i] = regVal[i]; //passing the data to ALU of the r type (7 stage) instruction
+			if(curCommand.op == OP_BEQ || curCommand.op == OP_BNE)
+			{
+				//then we need to stall the pipeline
+				L5r->next.data[0] = arch->registers[curCommand.r[0]];
+				L5r->next.data[1] = arch->registers[curCommand.r[1]];
+				curCommand = Instruction();
+				state->branchStall = 5; //so the next RR instruction gets stalled as well.
+				//and pass the commands forward as well	
+				if(!arch->outputFormat)
+					cout << "sent branch values ";
+				
+			}
+			else if(!arch->outputFormat) {
+				cout << "Rtype ";
+				cout << "passed " << regVal[0] << " " << regVal[1] << " "; 
+			}
+		}
+	}
+};
+
+struct EXDMData
+{
+	Instruction command;
+	int reg = -1;
+	int SWdata = 0;
+	int addr = 0;
+	int PC = -1;
+	void clear()
+	{
+		command = Instruction();
+		PC = -1;
+	}
+};
+struct EXDM : Latch<EXDMData> {};
+struct LWBData
+{
+	int reg = -1;
+	int dataOut = 0;
+	bool isUsingWriteBack = false;
+	int PC = -1;
+	void clear()
+	{
+		reg = -1;
+		isUsingWriteBack = false;
+		PC = -1;
+	}
+};
+struct LWB : Latch<LWBData> {};
+struct DM0
+{
+	MIPS_Architecture *arch;
+	EXDM *L7, *L8; //L8 here will be used for to transferring data from this stage to the DM1 stage
+	DM0(MIPS_Architecture *architecture, EXDM *l7, EXDM *l8)
+	{
+		arch = architecture; L7 = l7; L8 = l8;
+	}
+	void run()
+	{
+		 //transporting the value from the DM0 stage to the DM1 stage, where all the computation will happen
+		if(arch->outputFormat==0)
+			cout << "|DM0|=>";	
+		L8->next.PC = L7->cur.PC; //PC update
+		L8->next.addr = L7->cur.addr;
+		L8->next.command = L7->cur.command;
+		L8->next.reg = L7->cur.reg;
+		L8->next.SWdata = L7->cur.SWdata; 							
+	}
+};
+struct DM1
+{
+	MIPS_Architecture *arch;
+	EXDM *L8; LWB *L6; int Addr = 0;
+	int writeReg = -1; bool memWrite = false;
+	DM1(MIPS_Architecture *architecture, EXDM *l8, LWB *l6)
+	{
+		arch = architecture; L8 = l8; L6 = l6;
+	}
+	void run()
+	{
+		memWrite = false;
+		if(arch->outputFormat==0)
+			cout << "|DM1|=>";
+
+		if(L8->cur.command.op == OP_NOP)
+		{
+			// L6->nextIsWorking = false;
+			return;
+		}
+		memWrite = (L8->cur.command.op == OP_SW);
+		Addr = L8->cur.addr;
+		L6->next.PC = L8->cur.PC;
+		if(L8->cur.command.op == OP_LW)
+		{
+			L6->next.reg = L8->cur.reg;
+			L6->next.isUsingWriteBack = true;
+			L6->next.dataOut = arch->data.read(Addr);
+			arch->memoryStall += arch->caches.read(Addr) - 1;
+			if(!arch->outputFormat)
+				cout << "lw $" << L8->cur.reg << " " << L6->next.dataOut << " ";
+		}
+		else if(L8->cur.command.op == OP_SW)
+		{
+			arch->data.write(Addr, L8->cur.SWdata);
+			arch->memoryStall += arch->caches.write(Addr) - 1;
+			L6->next.isUsingWriteBack = false;
+			if(!arch->outputFormat)
+				cout << "sw " << L8->cur.SWdata << " " << Addr << " ";
+		}
+	}
+};
+
+struct EX
+{	
+	public:
+	int swData;
+	MIPS_Architecture *arch; State *state; RREX *L5; EXDM *L7; LWB *L6;
+	int iType = OP_NOP;
+	int dataValues[3] = {0}; 
+	int result = 0;
+	int r0; //register to be written into, this will not be used in this step but passed forward till the WriteBack stage where it will be written into
+	//now we decode the instruction from the instructions map
+	int checkforPC;
+	EX(MIPS_Architecture *architecture, State *shared, RREX *l5, EXDM *l7, LWB *l6)
+	{
+		state = shared;
+		arch = architecture; L5 = l5; L7 = l7; L6 = l6;//the latch reference and architecture reference is stored at initialization
+	}
+
+	void run()
+	{	
+		if(arch->outputFormat == 0)
+			cout << "|EX|=>";
+		if(state->stallNumber > 5)
+		{
+			//then we are supposed to stall and effectively do nothing
+			if(!arch->outputFormat)
+				cout << "**";
+			return;
+		}
+		if(state->branchStall > 5)
+		{
+			//then we are supposed to stall and effectively do nothing
+			if(!arch->outputFormat)
+				cout << "**";
+			return;
+		}
+		else
+		{
+			if(L5->cur.command.op == OP_NOP)
+			{
+				return; //a no-op
+			}
+			iType = L5->cur.command.op;
+			for (int i = 0; i < 3; i++)
+				dataValues[i] = L5->cur.data[i]; //getting the data from L3 in the nonforwarding case
+			r0 = L5->cur.command.r[0];   //the register to be written into
+		}
+		
+		//else we will work
+		if(L5->cur.command.type == 2)
+		{
+			//then this EX is of the 9 stage pipeline path
+			L7->next.PC = L5->cur.PC; //PC update
+			//in this case the address can be calculated by adding dataValues[0] and dataValues[1] 
+			//and dataValues[2] will be the data to be written into the memory incase of sw
+			int address = dataValues[0] + dataValues[1]; //this is indeed the address
+			if(address%4 != 0) cerr << "Error: Address not word aligned" << endl;
+				address = (uint32_t)address/4; //addresses are unsigned
+			if(arch->outputFormat == 0) cout << "address: " << address << " " << "<-" << dataValues[2];
+			L7->next.command = L5->cur.command;
+			L7->next.addr = address;
+			L7->next.reg = r0;
+			L7->next.SWdata = dataValues[2]; //this is the data to be written into the memory incase of sw       
+		}
+		else
+		{
+			//then this EX is of the 7stage pipeline path
+			if(iType == OP_BEQ || iType == OP_BNE)
+			{
+				state->branchStall = 0; state->stallNumber = 0;
+				if(arch->outputFormat==0) cout << dataValues[0] << "=?" << dataValues[1] << " ";
+				if((iType == OP_BNE)^(dataValues[0] == dataValues[1]))
+				{
+					//then we branch
+					L6->next.PC = L5->cur.PC; //PC update
+					arch->PCnext = L5->cur.command.target; //this moves the pc
+					//cout << curCOmm
+					L6->next.isUsingWriteBack = false;
+					if(!arch->outputFormat)
+						cout << "branched " << L6->next.PC << " ";
+					return;
+				}
+				else
+				{
+					//then we do not branch
+					L6->next.PC = L5->cur.PC; //PC update
+					L6->next.isUsingWriteBack = false;
+					if(!arch->outputFormat)
+						cout << "not branch " << L6->next.PC << " ";
+					return;
+				}
+			}
+			if(iType == OP_J)
+			{
+				//the jump already moved the pc in ID1, it only has to let its pc leave the pipeline
+				L6->next.PC = L5->cur.PC; //PC update
+				L6->next.isUsingWriteBack = false;
+				return;
+			}
+
+			L6->next.PC = L5->cur.PC; //PC update
+			int result = calc();
+			if(arch->outputFormat == 0) cout << "Result: " << result << " ";
+			L6->next.isUsingWriteBack = true;
+			L6->next.reg = r0;
+			L6->next.dataOut = result;
+		}
+	}
+	int calc()
+	{
+		switch(iType)
+		{
+		case OP_NOP:
+			return -1;
+		case OP_ADD: case OP_ADDI: case OP_LW: case OP_SW:
+			return dataValues[0] + dataValues[1];
+		case OP_SUB:
+			return dataValues[0] - dataValues[1];
+		case OP_MUL:
+			return dataValues[0] * dataValues[1];
+		case OP_AND: case OP_ANDI:
+			return (dataValues[0] & dataValues[1]);
+		case OP_OR: case OP_ORI:
+			return (dataValues[0] | dataValues[1]);
+		case OP_SRL:
+			return (dataValues[0] >> dataValues[1]);
+		case OP_SLL:
+			return (dataValues[0] << dataValues[1]);
+		default: //if slt
+			return (dataValues[0] < dataValues[1]);
+		}
+	}
+
+};
+
+struct WB
+{	public:
+	MIPS_Architecture *arch; State *state; LWB *dmwb, *exwb, *usingLatch;
+	int dataOut = 0; int reg = -1; int curPc = -1;
+	WB(MIPS_Architecture *architecture, State *shared, LWB *lwb1, LWB *lwb2)
+	{
+		state = shared;
+		arch = architecture; dmwb = lwb1; exwb = lwb2;
+	}
+	void run()
+	{
+		if(arch->outputFormat == 0)
+			cout << "|WB|=> ";
+		//check which one of these requires the writeback port, or if none require it.
+		state->pcs.erase(dmwb->cur.PC); state->pcs.erase(exwb->cur.PC); 
+		if(dmwb->cur.isUsingWriteBack && !(exwb->cur.isUsingWriteBack))
+		{
+			usingLatch = dmwb;
+		}
+		else if(exwb->cur.isUsingWriteBack && !(dmwb->cur.isUsingWriteBack))
+		{
+			usingLatch = exwb;
+		}
+		else if(!(dmwb->cur.isUsingWriteBack) && !(exwb->cur.isUsingWriteBack))
+		{
+			return; //do nothing this cycle
+		}
+		else
+		{
+			//then both are using the writeback port, so we would have stalled before in ID stage
+			//so we do nothing
+			// cerr << "both writing??";
+		}
+		//erasing both of those state->pcs
+		reg = usingLatch->cur.reg; dataOut = usingLatch->cur.dataOut;
+		curPc = usingLatch->cur.PC; //with this we get the pc 
+		if(arch->outputFormat == 0)
+			cout << "pcI:" << dmwb->cur.PC << "pcR:" << exwb->cur.PC  << " ";
+		if(reg != -1)
+		{
+			arch->registers[reg] = dataOut;
+			if(arch->outputFormat == 0)
+				cout << "$" << reg << ":" << dataOut << " ";
+		}
+	}
+};
+
+//the 7/9 stage pipeline: the state its stages share, its latches, then its stages in the order they run in a cycle along
+//with the latches they connect. The latches are L2, LIF, L3, L4, L5i, L5r, L6r, L7, L8i and L9
+using Pipeline79 = Pipeline<State, Latches<IFID, IFID, IDID, IDRR, RREX, RREX, LWB, EXDM, LWB, EXDM>,
+	Connect<ID1, 2, 3>,
+	Connect<ID0, 0, 2>,
+	Connect<IF0, 1>,
+	Connect<IF1, 1, 0>,
+	Connect<RR, 3, 4, 5>,
+	Connect<EX, 4, 7, 6>, //the i type path
+	Connect<EX, 5, 7, 6>, //the r type path
+	Connect<DM0, 7, 9>,
+	Connect<DM1, 9, 8>,
+	Connect<WB, 8, 6>>;
+
+//the pipeline running on arch, everything a simulation changes is in here or in arch so simulators can run side by side
+struct Simulator
+{
+	MIPS_Architecture *arch;
+	Pipeline79 pipeline;
+
+	Simulator(MIPS_Architecture *architecture) : arch(architecture), pipeline(architecture) {}
+
+	//starts over on program, reusing the memory of arch (see MIPS_Architecture::reset)
+	void reset(const MIPS_Architecture &program)
+	{
+		arch->reset(program);
+		pipeline.reset();
+	}
+
+	//runs the pipeline from the current state of arch until it drains and returns the number of cycles it took
+	int run()
+	{
+		pipeline.reset(); //left over from an earlier run
+		State &state = pipeline.state;
+		int clockCycles = 0;
+		DM1 &dataMem1 = pipeline.stage<8>();
+		do
+		{
+			state.setJumpStall();
+			pipeline.cycle(); //runs the stages and then updates the latches
+			if(arch->outputFormat == 0) 
+			{	
+				std::cout << " dataHazards are : ";
+				for(int reg = 0; reg < 32; reg++)
+				{	
+					if(state.DataHazards.has(reg))
+						std::cout << "$" << reg << " " << state.DataHazards.position[reg] <<   ", ";
+				}
+			}	
+			clockCycles++;
+			arch->timeFetches(clockCycles);
+			if(arch->outputFormat != 2)
+			{
+				arch->printRegisters(clockCycles);
+
+				if(dataMem1.memWrite)
+				{
+					cout << 1 << " "<< dataMem1.Addr << " " << dataMem1.L8->cur.SWdata;
+				}
+				else
+				{
+					cout << 0;
+				}
+			}
+			if(arch->trace)
+				arch->trace->cycle(arch->registers, dataMem1.memWrite, dataMem1.Addr, dataMem1.L8->cur.SWdata);
+			
+			state.DataHazards.age(8); //updating the hazards
+		
+			if(arch->outputFormat == 0)
+			{
+				cout << "^";
+				for (auto i: state.pcs)
+				{
+					cout << i << ".";
+				}
+			}
+			
+			//cout << endl << " at clockCycles " << clockCycles << endl;
+			if(arch->outputFormat != 2)
+				std::cout << endl;
+			clockCycles += arch->waitForMemory(clockCycles); //a cache miss holds up the whole pipeline
+			
+		} while((state.pcs.size() > 0));
+		return clockCycles;
+	}
+};
+
+//runs the pipeline once on arch, see Simulator::run
+int RunPipeline(MIPS_Architecture *arch)
+{
+	Simulator simulator(arch);
+	return simulator.run();
+}
+
+void ExecutePipelined(MIPS_Architecture *arch)
+	{
+		if (arch->decodeError != arch->SUCCESS)
+		{
+			arch->handleExit(arch->decodeError, 0);
+			return;
+		} //a command could not be decoded
+		if ((long long)arch->commands.size() >= arch->addressLimit / 4)
+		{
+			arch->handleExit(arch->MEMORY_ERROR, 0);
+			return;
+		} //memory error
+
+		//registers[registerMap["$sp"]] = (4 * commands.size()); //initializes position of sp. assumes that all the commands are also stored in data and so sp needs to be here
+		//the above is optional, but since none of the testcases utilize it, it has been commented out
+		int clockCycles = RunPipeline(arch);
+		arch->handleExit(arch->SUCCESS, clockCycles);
+
+	}
+
+} //namespace SevenNineStage
+
+#endif
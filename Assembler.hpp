@@ -0,0 +1,642 @@
+#ifndef __ASSEMBLER_HPP__
+#define __ASSEMBLER_HPP__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define ASSEMBLER_MMAP 1
+#else
+#define ASSEMBLER_MMAP 0
+#endif
+
+//opcodes of the pre-decoded instructions, OP_NOP is used by the pipelines as an empty slot (bubble)
+enum Opcode
+{
+	OP_NOP = 0,
+	OP_ADD, OP_SUB, OP_MUL, OP_AND, OP_OR, OP_SLT,	//R type
+	OP_ADDI, OP_ANDI, OP_ORI, OP_SRL, OP_SLL,		//I type (alu)
+	OP_LW, OP_SW,									//memory
+	OP_BEQ, OP_BNE, OP_J							//branch/jump
+};
+
+//an instruction decoded once by the Assembler, so that the pipelines never have to look at the strings again.
+//r[] holds the register operands in the order they are written in the source, -1 when that operand is not a register.
+//for lw and sw, r[1] is the base register and imm the byte offset, for beq/bne/j target is the index of the label.
+struct Instruction
+{
+	uint8_t op = OP_NOP;
+	uint8_t type = 3;	//same numbering as instructionNumber()
+	int8_t r[3] = {-1, -1, -1};
+	int32_t imm = 0;
+	int32_t target = -1;
+};
+
+//name of an opcode, used by the debugging output of the pipelines
+inline const char *opcodeName(int op)
+{
+	static const char *names[] = {"", "add", "sub", "mul", "and", "or", "slt", "addi", "andi", "ori", "srl", "sll", "lw", "sw", "beq", "bne", "j"};
+	return names[op];
+}
+
+//the text of a program, either mmap'ed or read into memory. Every token the assembler produces points into it, so it is
+//shared by all the copies of an architecture and only released by the last one
+struct SourceText
+{
+	const char *text = nullptr;
+	size_t size = 0;
+	bool mapped = false;
+	std::deque<std::string> joined; //the few tokens that are not a slice of text (more than 4 tokens on a line)
+
+	SourceText() {}
+	SourceText(const SourceText &) = delete;
+	SourceText &operator=(const SourceText &) = delete;
+	~SourceText()
+	{
+#if ASSEMBLER_MMAP
+		if (mapped)
+		{
+			munmap((void *)text, size);
+			return;
+		}
+#endif
+		delete[] text;
+	}
+};
+
+//the tokens of one command as they were written, always 4 of them with the missing ones empty
+struct SourceCommand
+{
+	std::string_view token[4];
+
+	const std::string_view &operator[](int i) const
+	{
+		return token[i];
+	}
+	const std::string_view *begin() const
+	{
+		return token;
+	}
+	const std::string_view *end() const
+	{
+		return token + 4;
+	}
+};
+
+//interned names, open addressing over FNV-1a hashes. The names point into the source text so nothing is copied
+struct SymbolTable
+{
+	std::vector<std::string_view> names;
+	std::vector<int> values;
+	std::vector<int> buckets; //index into names plus one, 0 when empty
+
+	static uint32_t hash(std::string_view name)
+	{
+		uint32_t h = 2166136261u;
+		for (char c : name)
+			h = (h ^ (unsigned char)c) * 16777619u;
+		return h;
+	}
+	//the id of name, -1 if it was never interned
+	int find(std::string_view name) const
+	{
+		if (buckets.empty())
+			return -1;
+		for (uint32_t i = hash(name) & (buckets.size() - 1);; i = (i + 1) & (buckets.size() - 1))
+		{
+			if (buckets[i] == 0)
+				return -1;
+			if (names[buckets[i] - 1] == name)
+				return buckets[i] - 1;
+		}
+	}
+	//the id of name, adding it (with value) if it is new. isNew says which of the two happened
+	int intern(std::string_view name, int value, bool &isNew)
+	{
+		if (2 * (names.size() + 1) > buckets.size())
+			grow();
+		uint32_t i = hash(name) & (buckets.size() - 1);
+		for (; buckets[i] != 0; i = (i + 1) & (buckets.size() - 1))
+			if (names[buckets[i] - 1] == name)
+			{
+				isNew = false;
+				return buckets[i] - 1;
+			}
+		isNew = true;
+		names.push_back(name);
+		values.push_back(value);
+		buckets[i] = names.size();
+		return names.size() - 1;
+	}
+	void grow()
+	{
+		buckets.assign(std::max<size_t>(64, 2 * buckets.size()), 0);
+		for (size_t n = 0; n < names.size(); ++n)
+		{
+			uint32_t i = hash(names[n]) & (buckets.size() - 1);
+			while (buckets[i] != 0)
+				i = (i + 1) & (buckets.size() - 1);
+			buckets[i] = n + 1;
+		}
+	}
+};
+
+//turns the text of a program into decoded instructions. The first pass goes over the text once, splitting every line into
+//string_views and defining the labels, the second pass decodes the commands now that every label is known.
+//the rules are the ones the old boost::tokenizer front end had, tokens are separated by ", \t" and # starts a comment.
+//
+//writeObject saves the result as an object file, which assembleFile recognises by its magic and maps instead of parsing.
+//the layout is (all little endian, as written by the host):
+//	"MIPSOBJ\0", version, sizeof(Instruction), the address limit it was decoded for, error, errorCommand,
+//	number of commands, number of labels, size of the text, then the instructions, the source line of every command,
+//	4 (offset, length) tokens per command, (offset, length, value) per label and finally the text they point into
+struct Assembler
+{
+	enum //same numbering as MIPS_Architecture::exit_code
+	{
+		SUCCESS = 0,
+		INVALID_REGISTER,
+		INVALID_LABEL,
+		INVALID_ADDRESS,
+		SYNTAX_ERROR
+	};
+
+	std::shared_ptr<SourceText> source;
+	std::vector<SourceCommand> commands;
+	std::vector<Instruction> program;
+	SymbolTable labels; //the value of a label is the index of the command it points to, -1 if it was defined twice
+	std::vector<int> lines; //the source line (from 1) of every command
+	int error = SUCCESS, errorCommand = 0; //the first command that could not be decoded
+	long long addressLimit;
+
+	static constexpr char objectMagic[8] = {'M', 'I', 'P', 'S', 'O', 'B', 'J', 0};
+	static const uint32_t objectVersion = 1;
+
+	Assembler(long long addressLimit)
+	{
+		this->addressLimit = addressLimit;
+		source = std::make_shared<SourceText>();
+	}
+
+	//maps the file (or reads it when mmap is not available), which holds either source or an object written by
+	//writeObject. returns false if it can not be opened or is a damaged object
+	bool assembleFile(const std::string &fileName)
+	{
+#if ASSEMBLER_MMAP
+		int fd = open(fileName.c_str(), O_RDONLY);
+		struct stat status;
+		if (fd < 0 || fstat(fd, &status) != 0)
+		{
+			if (fd >= 0)
+				close(fd);
+			return false;
+		}
+		if (status.st_size > 0)
+		{
+			void *p = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED)
+			{
+				source->text = (const char *)p;
+				source->size = status.st_size;
+				source->mapped = true;
+			}
+		}
+		close(fd);
+		if (status.st_size == 0 || source->mapped)
+			return assemble();
+#endif
+		std::ifstream file(fileName, std::ios::binary);
+		if (!file.is_open())
+			return false;
+		return assembleStream(file);
+	}
+
+	//for programs that only come as a stream, they are read into memory first
+	bool assembleStream(std::istream &file)
+	{
+		std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		char *copy = new char[text.size()];
+		text.copy(copy, text.size());
+		source->text = copy;
+		source->size = text.size();
+		return assemble();
+	}
+
+	bool assemble()
+	{
+		if (source->size >= sizeof(objectMagic) && memcmp(source->text, objectMagic, sizeof(objectMagic)) == 0)
+			return readObject();
+		std::vector<std::string_view> tokens; //reused for every line
+		const char *p = source->text, *end = source->text + source->size;
+		for (int line = 1; p < end; ++line)
+		{
+			const char *lineEnd = (const char *)memchr(p, '\n', end - p);
+			if (!lineEnd)
+				lineEnd = end;
+			const char *comment = (const char *)memchr(p, '#', lineEnd - p);
+			tokenize(p, comment ? comment : lineEnd, tokens);
+			if (addLine(tokens))
+				lines.push_back(line);
+			p = lineEnd + 1;
+		}
+		decodeCommands();
+		return true;
+	}
+
+	void decodeCommands()
+	{
+		error = SUCCESS;
+		errorCommand = 0;
+		program.assign(commands.size(), Instruction());
+		for (int i = 0; i < (int)commands.size(); ++i)
+		{
+			int code = decodeCommand(commands[i], program[i]);
+			if (code != SUCCESS && error == SUCCESS)
+			{
+				error = code;
+				errorCommand = i;
+			}
+		}
+	}
+
+	static bool isSeparator(char c)
+	{
+		return c == ',' || c == ' ' || c == '\t';
+	}
+	static void tokenize(const char *p, const char *end, std::vector<std::string_view> &tokens)
+	{
+		tokens.clear();
+		while (true)
+		{
+			while (p < end && isSeparator(*p))
+				++p;
+			if (p == end)
+				return;
+			const char *start = p;
+			while (p < end && !isSeparator(*p))
+				++p;
+			tokens.push_back(std::string_view(start, p - start));
+		}
+	}
+
+	void defineLabel(std::string_view label)
+	{
+		bool isNew;
+		int id = labels.intern(label, commands.size(), isNew);
+		if (!isNew)
+			labels.values[id] = -1;
+	}
+
+	//splits the label off a line and keeps what is left as a command, returns false if nothing was left
+	bool addLine(std::vector<std::string_view> &tokens)
+	{
+		if (tokens.empty()) //empty line or a comment only line
+			return false;
+		size_t first = 0;
+		std::string_view &head = tokens[0];
+		if (tokens.size() == 1)
+		{
+			if (head.back() == ':')
+				defineLabel(head.substr(0, head.size() - 1));
+			return false; //a lone token that is not a label is ignored
+		}
+		else if (head.back() == ':')
+		{
+			defineLabel(head.substr(0, head.size() - 1));
+			first = 1;
+		}
+		else if (head.find(':') != std::string_view::npos)
+		{
+			size_t idx = head.find(':');
+			defineLabel(head.substr(0, idx));
+			head = head.substr(idx + 1);
+		}
+		else if (tokens[1][0] == ':')
+		{
+			defineLabel(head);
+			tokens[1] = tokens[1].substr(1);
+			first = tokens[1].empty() ? 2 : 1;
+		}
+		if (first == tokens.size())
+			return false;
+		SourceCommand command;
+		for (size_t i = first; i < tokens.size() && i < first + 4; ++i)
+			command.token[i - first] = tokens[i];
+		if (tokens.size() > first + 4) //the extra tokens go with the last operand, separated by spaces
+		{
+			std::string joined(command.token[3]);
+			for (size_t i = first + 4; i < tokens.size(); ++i)
+				joined += " " + std::string(tokens[i]);
+			source->joined.push_back(joined);
+			command.token[3] = source->joined.back();
+		}
+		commands.push_back(command);
+		return true;
+	}
+
+	//writes what was assembled as an object file, returns false (with a message on cerr) if that fails
+	bool writeObject(const std::string &fileName) const
+	{
+		std::ofstream out(fileName, std::ios::binary);
+		if (!out.is_open())
+		{
+			std::cerr << "Could not open object file " << fileName << " for writing\n";
+			return false;
+		}
+		auto put = [&out](auto value)
+		{
+			out.write((const char *)&value, sizeof(value));
+		};
+		uint64_t textBytes = 0;
+		for (auto &command : commands)
+			for (auto &token : command)
+				textBytes += token.size();
+		for (auto &name : labels.names)
+			textBytes += name.size();
+		out.write(objectMagic, sizeof(objectMagic));
+		put(objectVersion);
+		put((uint32_t)sizeof(Instruction));
+		put((int64_t)addressLimit);
+		put((int32_t)error);
+		put((int32_t)errorCommand);
+		put((uint32_t)commands.size());
+		put((uint32_t)labels.names.size());
+		put(textBytes);
+		out.write((const char *)program.data(), program.size() * sizeof(Instruction));
+		out.write((const char *)lines.data(), lines.size() * sizeof(int));
+		uint32_t offset = 0;
+		for (auto &command : commands)
+			for (auto &token : command)
+			{
+				put(offset);
+				put((uint32_t)token.size());
+				offset += token.size();
+			}
+		for (size_t i = 0; i < labels.names.size(); ++i)
+		{
+			put(offset);
+			put((uint32_t)labels.names[i].size());
+			put((int32_t)labels.values[i]);
+			offset += labels.names[i].size();
+		}
+		for (auto &command : commands)
+			for (auto &token : command)
+				out.write(token.data(), token.size());
+		for (auto &name : labels.names)
+			out.write(name.data(), name.size());
+		if (!out)
+		{
+			std::cerr << "Could not write object file " << fileName << '\n';
+			return false;
+		}
+		return true;
+	}
+
+	//reads the object file in source, the tokens and labels point straight into it. Everything is checked so that a
+	//damaged file can not send the pipelines out of range: every instruction must look exactly like one decodeCommand
+	//could have produced. If it was decoded for a different address limit the commands are decoded again, since constant
+	//addresses are checked against it, and so are those of a program with an error
+	bool readObject()
+	{
+		const char *p = source->text + sizeof(objectMagic), *end = source->text + source->size;
+		auto get = [&p, end](auto &value)
+		{
+			if ((size_t)(end - p) < sizeof(value))
+				return false;
+			memcpy(&value, p, sizeof(value));
+			p += sizeof(value);
+			return true;
+		};
+		uint32_t version, instructionBytes, commandTotal, labelTotal;
+		int64_t objectLimit;
+		int32_t objectError, objectErrorCommand;
+		uint64_t textBytes;
+		bool ok = get(version) && version == objectVersion && get(instructionBytes) && instructionBytes == sizeof(Instruction) &&
+				  get(objectLimit) && get(objectError) && get(objectErrorCommand) && get(commandTotal) && get(labelTotal) && get(textBytes);
+		uint64_t tableBytes = (uint64_t)commandTotal * (sizeof(Instruction) + sizeof(int) + 32) + (uint64_t)labelTotal * 12;
+		ok = ok && tableBytes + textBytes == (uint64_t)(end - p);
+		if (!ok)
+		{
+			std::cerr << "Object file is damaged or from another version, assemble it again\n";
+			return false;
+		}
+		const char *text = end - textBytes;
+		auto view = [&](std::string_view &token)
+		{
+			uint32_t offset, length;
+			if (!get(offset) || !get(length) || (uint64_t)offset + length > textBytes)
+				return false;
+			token = std::string_view(text + offset, length);
+			return true;
+		};
+		program.resize(commandTotal);
+		lines.resize(commandTotal);
+		commands.resize(commandTotal);
+		memcpy(program.data(), p, commandTotal * sizeof(Instruction));
+		p += commandTotal * sizeof(Instruction);
+		memcpy(lines.data(), p, commandTotal * sizeof(int));
+		p += commandTotal * sizeof(int);
+		//a program with an error never runs, and its commands after the first bad one are only partly decoded
+		if (objectError == SUCCESS)
+			for (auto &ins : program)
+				ok = ok && isDecoded(ins, commandTotal);
+		for (auto &command : commands)
+			for (auto &token : command.token)
+				ok = ok && view(token);
+		for (uint32_t i = 0; ok && i < labelTotal; ++i)
+		{
+			std::string_view name;
+			int32_t value;
+			bool isNew;
+			ok = view(name) && get(value) && value >= -1 && value <= (int)commandTotal;
+			if (ok)
+				labels.values[labels.intern(name, value, isNew)] = value;
+		}
+		ok = ok && objectError >= SUCCESS && objectError <= SYNTAX_ERROR && objectErrorCommand >= 0 && (objectErrorCommand < (int)commandTotal || objectError == SUCCESS);
+		if (!ok)
+		{
+			std::cerr << "Object file is damaged or from another version, assemble it again\n";
+			return false;
+		}
+		error = objectError;
+		errorCommand = objectErrorCommand;
+		if (objectLimit != addressLimit || objectError != SUCCESS)
+			decodeCommands();
+		return true;
+	}
+
+	// checks if label is valid
+	static bool checkLabel(std::string_view str)
+	{
+		if (str.empty() || !isalpha((unsigned char)str[0]))
+			return false;
+		for (size_t i = 1; i < str.size(); ++i)
+			if (!isalnum((unsigned char)str[i]))
+				return false;
+		return true;
+	}
+
+	//the number of a register name like $t0 or $8, -1 if it is not one
+	static int registerNumber(std::string_view name)
+	{
+		static const std::unordered_map<std::string_view, int> registers = []
+		{
+			static const char *names[] = {"$zero", "$at", "$v0", "$v1", "$a0", "$a1", "$a2", "$a3",
+				"$t0", "$t1", "$t2", "$t3", "$t4", "$t5", "$t6", "$t7", "$s0", "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7",
+				"$t8", "$t9", "$k0", "$k1", "$gp", "$sp", "$s8", "$ra"};
+			static const char *numbers[] = {"$0", "$1", "$2", "$3", "$4", "$5", "$6", "$7", "$8", "$9", "$10", "$11", "$12", "$13", "$14", "$15",
+				"$16", "$17", "$18", "$19", "$20", "$21", "$22", "$23", "$24", "$25", "$26", "$27", "$28", "$29", "$30", "$31"};
+			std::unordered_map<std::string_view, int> table;
+			for (int i = 0; i < 32; ++i)
+				table[names[i]] = i, table[numbers[i]] = i;
+			return table;
+		}();
+		auto it = registers.find(name);
+		return it == registers.end() ? -1 : it->second;
+	}
+
+	//parses a number the way stoi/stoll do: leading white space, an optional sign and at least one digit, stopping at
+	//the first character that is not a digit. false if there are no digits or the value is outside [low, high]
+	static bool parseNumber(std::string_view s, long long low, long long high, long long &value)
+	{
+		size_t i = 0;
+		while (i < s.size() && isspace((unsigned char)s[i]))
+			++i;
+		bool negative = false;
+		if (i < s.size() && (s[i] == '+' || s[i] == '-'))
+			negative = (s[i++] == '-');
+		if (i == s.size() || !isdigit((unsigned char)s[i]))
+			return false;
+		unsigned long long magnitude = 0;
+		for (; i < s.size() && isdigit((unsigned char)s[i]); ++i)
+		{
+			if (magnitude > (1ULL << 63) / 10)
+				return false;
+			magnitude = magnitude * 10 + (s[i] - '0');
+		}
+		if (negative ? magnitude > (unsigned long long)-(low + 1) + 1 : magnitude > (unsigned long long)high)
+			return false;
+		value = negative ? (long long)(0 - magnitude) : (long long)magnitude;
+		return true;
+	}
+
+	// decodes a memory operand like 8($s0), ($s0) or 1000 into the base register and byte offset
+	int decodeMemoryOperand(std::string_view location, Instruction &ins)
+	{
+		if (location.empty())
+			return SYNTAX_ERROR;
+		long long value;
+		if (location.back() == ')')
+		{
+			size_t lparen = location.find('(');
+			if (lparen == std::string_view::npos)
+				return SYNTAX_ERROR;
+			int reg = registerNumber(location.substr(lparen + 1, location.size() - lparen - 2));
+			if (reg < 0)
+				return INVALID_REGISTER;
+			if (lparen == 0)
+				value = 0;
+			else if (!parseNumber(location.substr(0, lparen), INT32_MIN, INT32_MAX, value))
+				return SYNTAX_ERROR;
+			ins.imm = value;
+			ins.r[1] = reg;
+			return SUCCESS;
+		}
+		if (!parseNumber(location, INT64_MIN, INT64_MAX, value))
+			return SYNTAX_ERROR;
+		if (value % 4 || value < 0 || value >= addressLimit)
+			return INVALID_ADDRESS;
+		ins.imm = (int32_t)(uint32_t)value; //addresses are unsigned 32 bit, see FunctionalModel
+		ins.r[1] = 0;
+		return SUCCESS;
+	}
+
+	// decodes the label of a branch or jump into the index of the command it points to
+	int decodeLabel(std::string_view label, Instruction &ins)
+	{
+		if (!checkLabel(label))
+			return SYNTAX_ERROR;
+		int id = labels.find(label);
+		if (id < 0 || labels.values[id] == -1)
+			return INVALID_LABEL;
+		ins.target = labels.values[id];
+		return SUCCESS;
+	}
+
+	//the type of an opcode, same numbering as instructionNumber()
+	static int instructionType(int op)
+	{
+		return (op <= OP_SLT) ? 0 : (op <= OP_SLL) ? 1 : (op <= OP_SW) ? 2 : 3;
+	}
+
+	//how many of r[] an opcode uses, the base register of lw and sw included
+	static int registerOperands(int op)
+	{
+		return (op == OP_J) ? 0 : (instructionType(op) == 0) ? 3 : 2;
+	}
+
+	//true if ins is what decodeCommand makes of a valid command of a program with commandTotal commands
+	static bool isDecoded(const Instruction &ins, uint32_t commandTotal)
+	{
+		if (ins.op == OP_NOP || ins.op > OP_J || ins.type != instructionType(ins.op))
+			return false;
+		for (int i = 0; i < 3; ++i)
+			if (i < registerOperands(ins.op) ? (ins.r[i] < 0 || ins.r[i] >= 32) : ins.r[i] != -1)
+				return false;
+		if (ins.type == 3)
+			return ins.target >= 0 && ins.target <= (int)commandTotal;
+		return ins.target == -1;
+	}
+
+	// decodes one command into an instruction, returns one of the exit codes
+	int decodeCommand(const SourceCommand &command, Instruction &ins)
+	{
+		static const std::unordered_map<std::string_view, int> opcodes = {
+			{"add", OP_ADD}, {"sub", OP_SUB}, {"mul", OP_MUL}, {"and", OP_AND}, {"or", OP_OR}, {"slt", OP_SLT},
+			{"addi", OP_ADDI}, {"andi", OP_ANDI}, {"ori", OP_ORI}, {"srl", OP_SRL}, {"sll", OP_SLL},
+			{"lw", OP_LW}, {"sw", OP_SW}, {"beq", OP_BEQ}, {"bne", OP_BNE}, {"j", OP_J}};
+		auto it = opcodes.find(command[0]);
+		if (it == opcodes.end())
+			return SYNTAX_ERROR;
+		ins.op = it->second;
+		ins.type = instructionType(ins.op);
+		if (ins.op == OP_J)
+			return (!command[2].empty() || !command[3].empty()) ? SYNTAX_ERROR : decodeLabel(command[1], ins);
+		int operands = (ins.type == 2) ? 1 : registerOperands(ins.op); //the leading ones, the base of lw/sw comes later
+		for (int i = 0; i < operands; ++i)
+		{
+			int reg = registerNumber(command[i + 1]);
+			if (reg < 0)
+				return INVALID_REGISTER;
+			ins.r[i] = reg;
+		}
+		if (ins.type == 1)
+		{
+			long long value;
+			if (!parseNumber(command[3], INT32_MIN, INT32_MAX, value))
+				return SYNTAX_ERROR;
+			ins.imm = value;
+		}
+		else if (ins.type == 2)
+			return !command[3].empty() ? SYNTAX_ERROR : decodeMemoryOperand(command[2], ins);
+		else if (ins.type == 3)
+			return decodeLabel(command[3], ins);
+		return SUCCESS;
+	}
+};
+
+#endif
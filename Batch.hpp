@@ -0,0 +1,240 @@
+#ifndef __BATCH_HPP__
+#define __BATCH_HPP__
+
+#include <MIPS_Processor.hpp>
+#include <ThreadPool.hpp>
+#include <5stage.hpp>
+#include <5stage_bypass.hpp>
+#include <79stage.hpp>
+#include <parametric.hpp>
+#include <filesystem>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+//batch simulation of a whole corpus of programs in one process. Every program is a task on a ThreadPool that parses it
+//(unless a program with the same contents was parsed already), runs the chosen pipeline on it and hands back a one line
+//summary, and the summaries are written out in the order the programs were given as soon as they are ready.
+//A worker keeps one MIPS_Architecture and resets it to each program it runs (see MIPS_Architecture::reset), so the
+//data memory and the program vectors are not allocated again for every file.
+namespace Batch
+{
+
+//FNV-1a
+inline uint64_t hash(const char *bytes, size_t size, uint64_t h = 14695981039346656037ULL)
+{
+	for (size_t i = 0; i < size; ++i)
+		h = (h ^ (unsigned char)bytes[i]) * 1099511628211ULL;
+	return h;
+}
+
+//a hash of the registers and of every non-zero word of data with its address, two runs ending in the same state have
+//the same hash
+uint64_t stateHash(const MIPS_Architecture *arch)
+{
+	uint64_t h = hash((const char *)arch->registers, sizeof(arch->registers));
+	for (uint32_t number : arch->data.sortedPages())
+	{
+		const int *page = arch->data.page(number);
+		for (uint32_t i = 0; i < PagedMemory::PAGE_WORDS; ++i)
+			if (page[i] != 0)
+			{
+				uint32_t word = (number << PagedMemory::PAGE_BITS) + i;
+				h = hash((const char *)&word, sizeof(word), h);
+				h = hash((const char *)&page[i], sizeof(int), h);
+			}
+	}
+	return h;
+}
+
+//the programs listed in a manifest (one file name per line, relative ones are relative to the manifest, # starts a
+//comment) or found under a directory (every .asm and .obj file, in name order). false if path can not be read
+bool listPrograms(const string &path, vector<string> &programs)
+{
+	namespace fs = std::filesystem;
+	std::error_code error;
+	if (fs::is_directory(path, error))
+	{
+		vector<string> found;
+		for (fs::recursive_directory_iterator it(path, error), end; !error && it != end; it.increment(error))
+			if (it->is_regular_file(error) && (it->path().extension() == ".asm" || it->path().extension() == ".obj"))
+				found.push_back(it->path().string());
+		sort(found.begin(), found.end());
+		programs.insert(programs.end(), found.begin(), found.end());
+		return !error;
+	}
+	ifstream manifest(path);
+	if (!manifest.is_open())
+		return false;
+	fs::path base = fs::path(path).parent_path();
+	string line;
+	while (getline(manifest, line))
+	{
+		line = line.substr(0, line.find('#'));
+		size_t first = line.find_first_not_of(" \t\r"), last = line.find_last_not_of(" \t\r");
+		if (first == string::npos)
+			continue;
+		fs::path program = line.substr(first, last - first + 1);
+		programs.push_back((program.is_relative() ? base / program : program).string());
+	}
+	return true;
+}
+
+//the parsed programs by the hash of their contents, shared by all the workers. Each one is parsed by whichever task
+//asks for it first while the others asking for it wait
+struct ParseCache
+{
+	struct Entry
+	{
+		std::once_flag parsed;
+		unique_ptr<MIPS_Architecture> program; //nullptr if it could not be parsed
+	};
+
+	std::mutex lock;
+	unordered_map<uint64_t, shared_ptr<Entry>> entries;
+	std::atomic<long long> parses{0};
+
+	//the program in fileName, whose contents hash to key, nullptr if it can not be parsed
+	const MIPS_Architecture *get(uint64_t key, const string &fileName)
+	{
+		shared_ptr<Entry> entry;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			shared_ptr<Entry> &slot = entries[key];
+			if (!slot)
+				slot = make_shared<Entry>();
+			entry = slot;
+		}
+		std::call_once(entry->parsed, [&]
+		{
+			bool loaded;
+			entry->program.reset(new MIPS_Architecture(fileName, loaded));
+			if (!loaded)
+				entry->program.reset();
+			parses++;
+		});
+		return entry->program.get();
+	}
+};
+
+struct Summary
+{
+	int exitCode = MIPS_Architecture::SUCCESS; //-1 if the file could not be read
+	long long instructions = 0, cycles = 0;
+	uint64_t state = 0;
+};
+
+struct Runner
+{
+	vector<string> programs;
+	std::function<int(MIPS_Architecture *, int &)> runPipeline; //returns the cycles and sets the exit code
+	ParseCache cache;
+	vector<unique_ptr<MIPS_Architecture>> workers; //the architecture of each worker of the pool, made on first use
+
+	std::mutex outLock;
+	vector<Summary> summaries;
+	vector<char> finished;
+	size_t written = 0;
+
+	//the model is 5stage, 5stage_bypass, 79stage or a config file of the parametric model, false (with a message on
+	//cerr) if it is none of them
+	bool setModel(const string &model)
+	{
+		if (model == "5stage" || model == "5stage_bypass" || model == "79stage")
+		{
+			int (*run)(MIPS_Architecture *) = (model == "5stage") ? FiveStage::RunPipeline :
+				(model == "5stage_bypass") ? FiveStageBypass::RunPipeline : SevenNineStage::RunPipeline;
+			runPipeline = [run](MIPS_Architecture *arch, int &exitCode)
+			{
+				exitCode = MIPS_Architecture::SUCCESS;
+				return run(arch);
+			};
+			return true;
+		}
+		ParametricStage::Config config;
+		if (!config.load(model))
+			return false;
+		runPipeline = [config](MIPS_Architecture *arch, int &exitCode)
+		{
+			return ParametricStage::RunPipeline(arch, config, exitCode);
+		};
+		return true;
+	}
+
+	//arch is the architecture of the worker running it, made here the first time
+	Summary simulate(const string &fileName, unique_ptr<MIPS_Architecture> &arch)
+	{
+		Summary summary;
+		ifstream file(fileName, ios::binary);
+		if (!file.is_open())
+		{
+			summary.exitCode = -1;
+			return summary;
+		}
+		stringstream contents;
+		contents << file.rdbuf();
+		string bytes = contents.str();
+		const MIPS_Architecture *program = cache.get(hash(bytes.data(), bytes.size()), fileName);
+		if (!program)
+		{
+			summary.exitCode = -1;
+			return summary;
+		}
+		summary.exitCode = program->decodeError;
+		if (summary.exitCode == MIPS_Architecture::SUCCESS && (long long)program->commands.size() >= program->addressLimit / 4)
+			summary.exitCode = MIPS_Architecture::MEMORY_ERROR;
+		if (summary.exitCode != MIPS_Architecture::SUCCESS)
+			return summary;
+		if (!arch)
+			arch.reset(new MIPS_Architecture(*program));
+		arch->reset(*program);
+		arch->outputFormat = 2;
+		summary.cycles = runPipeline(arch.get(), summary.exitCode);
+		for (int count : arch->commandCount)
+			summary.instructions += count;
+		summary.state = stateHash(arch.get());
+		return summary;
+	}
+
+	static string status(int exitCode)
+	{
+		static const char *names[] = {"ok", "invalid_register", "invalid_label", "invalid_address", "syntax_error", "memory_error"};
+		return exitCode < 0 ? "unreadable" : names[exitCode];
+	}
+
+	//writes the summaries that are ready and have nothing before them still running, outLock must be held
+	void writeReady(ostream &out)
+	{
+		for (; written < programs.size() && finished[written]; ++written)
+		{
+			Summary &s = summaries[written];
+			out << programs[written] << '\t' << status(s.exitCode) << '\t' << s.instructions << '\t' << s.cycles << '\t'
+				<< hex << setw(16) << setfill('0') << s.state << dec << setfill(' ') << '\n';
+		}
+		out.flush();
+	}
+
+	//runs every program on pool and streams their summaries to out, one tab separated line each
+	void run(ThreadPool &pool, ostream &out)
+	{
+		summaries.assign(programs.size(), Summary());
+		finished.assign(programs.size(), false);
+		workers.resize(pool.size());
+		written = 0;
+		out << "program\tstatus\tinstructions\tcycles\tstate\n";
+		for (size_t i = 0; i < programs.size(); ++i)
+			pool.submit([this, i, &pool, &out]
+			{
+				Summary summary = simulate(programs[i], workers[pool.index()]);
+				std::lock_guard<std::mutex> guard(outLock);
+				summaries[i] = summary;
+				finished[i] = true;
+				writeReady(out);
+			});
+		pool.wait();
+	}
+};
+
+} //namespace Batch
+
+#endif
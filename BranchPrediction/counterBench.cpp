@@ -0,0 +1,110 @@
+#include<BranchPredictor.hpp>
+#include<chrono>
+
+//the saturating predictor as it was before CounterTable, a bitset<2> (a whole word) per counter and a flip sequence
+//per update, to time the packed table against
+struct BitsetSaturatingBranchPredictor : public BranchPredictor {
+    vector<bitset<2>> table;
+    uint32_t mask;
+    BitsetSaturatingBranchPredictor(int value, int bits = 14) : table(1 << bits, value), mask((1u << bits) - 1) {}
+
+    bool predict(uint32_t pc) {
+        return table[pc & mask][1] == 1;
+    }
+
+    void update(uint32_t pc, bool taken) {
+        int index = (pc & mask);
+        if(taken)
+        {
+            if(table[index].count() == 2) return;
+            if(table[index][0] == 1) //01 goes to 10
+            {
+                table[index][0].flip(); table[index][1].flip();
+            }
+            else //00 goes to 01, 10 goes to 11
+            {
+                table[index][0].flip();
+            }
+        }
+        else
+        {
+            if(table[index].count() == 0) return;
+            if(table[index][0] == 1) //01 or 11 goes to 00 or 10
+            {
+                table[index][0].flip();
+            }
+            else //10 goes to 01
+            {
+                table[index][0].flip(); table[index][1].flip();
+            }
+        }
+    }
+};
+
+struct Branch {
+    uint32_t pc;
+    bool taken;
+};
+
+//replays trace through a predictor, returns the mispredictions and sets the nanoseconds per branch
+long long replay(BranchPredictor &predictor, const vector<Branch> &trace, double &nanoseconds)
+{
+    long long wrong = 0;
+    auto start = chrono::steady_clock::now();
+    for (const Branch &b : trace)
+    {
+        wrong += predictor.predict(b.pc) != b.taken;
+        predictor.update(b.pc, b.taken);
+    }
+    nanoseconds = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / trace.size();
+    return wrong;
+}
+
+void compare(const string &name, const vector<Branch> &trace, int bits)
+{
+    BitsetSaturatingBranchPredictor bitsets(1, bits);
+    SaturatingBranchPredictor packed(1, bits);
+    double before, after;
+    long long wrongBefore = replay(bitsets, trace, before), wrongAfter = replay(packed, trace, after);
+    cout << name << ", 2^" << bits << " counters (" << (sizeof(bitset<2>) << bits) / 1024 << "KB as bitsets, "
+         << packed.table.words.size() * 8 / 1024 << "KB packed): " << before << " ns per branch before, " << after
+         << " after, " << before / after << "x" << (wrongBefore == wrongAfter ? "" : ", THE PREDICTIONS DIFFER") << endl;
+}
+
+//times the saturating predictor with bitset<2> counters against the packed CounterTable on the same branches:
+//branchtrace.txt (or the trace given, lines of a hex pc and 0 or 1) replayed over and over, and branches spread over
+//the whole table the way a large program's would be
+//./counterBench [trace file] [millions of branches]
+int main(int argc, char *argv[])
+{
+    string traceName = argc > 1 ? argv[1] : "branchtrace.txt";
+    size_t total = (argc > 2 ? atoi(argv[2]) : 50) * (size_t)1000000;
+    vector<Branch> recorded;
+    ifstream file(traceName);
+    string pc;
+    int taken;
+    while (file >> pc >> taken)
+        recorded.push_back({(uint32_t)stoul(pc, nullptr, 16), taken != 0});
+    if (recorded.empty())
+    {
+        cout << "no branches in " << traceName << endl;
+        return -1;
+    }
+    vector<Branch> trace(total);
+    for (size_t i = 0; i < total; ++i)
+        trace[i] = recorded[i % recorded.size()];
+    compare(traceName + " replayed", trace, 14);
+
+    //each pc mostly goes one way, every tenth time the other
+    uint32_t random = 0x9E3779B9;
+    for (size_t i = 0; i < total; ++i)
+    {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        trace[i] = {random, (bool)(((random & 1048575) * 2654435761u >> 31) ^ (i % 10 == 0))};
+    }
+    compare("Random pcs", trace, 14);
+    compare("Random pcs", trace, 20);
+    return 0;
+}
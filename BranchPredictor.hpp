@@ -3,7 +3,10 @@
 
 #include <vector>
 #include <bitset>
+#include <deque>
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 #include <iostream>
 #include<iostream>
 #include<string>
@@ -16,187 +19,606 @@ using namespace std;
 struct BranchPredictor {
     virtual bool predict(uint32_t pc) = 0;
     virtual void update(uint32_t pc, bool taken) =0;
+    virtual ~BranchPredictor() {}
 };
 
-struct SaturatingBranchPredictor : public BranchPredictor {
-    vector<bitset<2>> table;
-    SaturatingBranchPredictor(int value) : table(1 << 14, value) {}
+//predicts the same direction for every branch, always not taken unless told otherwise
+struct StaticBranchPredictor : public BranchPredictor {
+    bool taken;
+    StaticBranchPredictor(bool alwaysTaken = false) : taken(alwaysTaken) {}
+    bool predict(uint32_t) { return taken; }
+    void update(uint32_t, bool) {}
+};
 
-    bool predict(uint32_t pc) {
-       int index = (pc & 16383); //the 14 lsbs of the pc
-         if(table[index][1] == 1)
-              return true;
-         else
-              return false;
-    }
+//2 bit saturating counters packed 32 to a 64 bit word, so a table of 2^14 of them takes 4KB and stays in L1. A counter
+//goes up when taken and down when not, stopping at 0 and 3, and 2 and 3 predict taken. update moves it without a branch:
+//the step is +1, -1 or 0 and is xored into the word in place
+struct CounterTable {
+    vector<uint64_t> words;
 
-    void update(uint32_t pc, bool taken) {
-        int index = (pc & 16383);
-        if(taken)
-        {
-            if(table[index].count() == 2) return; //if both are already 1
-            if(table[index][0] == 1) //01 goes to 10
-            {
-                table[index][0].flip(); table[index][1].flip();
-            }
-            else //00 goes to 01, 10 goes to 11
-            {
-                table[index][0].flip(); //updating this bit to 1
-            }
-        }
-        else
-        {
-            if(table[index].count() == 0) return; //if both are already 0 return s the number bit whih are set
-            if(table[index][0] == 1) //01 or 11 goes to 00 or 10
-            {
-                table[index][0].flip(); //updating this bit to 0
-            }
-            else //10 goes to 01 (00 case is not there as its already taken care of)
-            {
-                table[index][0].flip(); table[index][1].flip();
-            }
-        }
-        
+    CounterTable(size_t size = 0, int value = 0) { assign(size, value); }
+
+    //size counters, all in state value
+    void assign(size_t size, int value) { words.assign((size + 31) / 32, 0x5555555555555555ULL * (value & 3)); }
+
+    int get(uint32_t index) const { return (words[index >> 5] >> ((index & 31) * 2)) & 3; }
+    bool taken(uint32_t index) const { return get(index) >> 1; }
+
+    void update(uint32_t index, bool taken) {
+        uint64_t &word = words[index >> 5];
+        int shift = (index & 31) * 2;
+        uint64_t counter = (word >> shift) & 3;
+        uint64_t next = counter + (taken & (counter != 3)) - (!taken & (counter != 0));
+        word ^= (counter ^ next) << shift;
     }
 };
 
+struct SaturatingBranchPredictor : public BranchPredictor {
+    CounterTable table;
+    uint32_t mask; //the table has 2^bits counters, indexed by that many lsbs of the pc
+    SaturatingBranchPredictor(int value, int bits = 14) : table(1 << bits, value), mask((1u << bits) - 1) {}
+
+    bool predict(uint32_t pc) { return table.taken(pc & mask); } //the 14 lsbs of the pc by default
+    void update(uint32_t pc, bool taken) { table.update(pc & mask, taken); }
+};
+
+//a counter for each of the 4 outcomes the last two branches can have had
 struct BHRBranchPredictor : public BranchPredictor {
-    std::vector<std::bitset<2>> bhrTable;
+    CounterTable bhrTable;
     std::bitset<2> bhr;
     BHRBranchPredictor(int value) : bhrTable(1 << 2, value), bhr(value) {}
-    bool predict(uint32_t pc) {  //we don't require the the p for indexing 
-        int ind = bhr.to_ulong();
-        if(bhrTable[ind][1] == 1)
-            return true;
-        else
-            return false;
-    }
+    bool predict(uint32_t) { return bhrTable.taken(bhr.to_ulong()); } //we don't require the the p for indexing 
 
-    void update(uint32_t pc, bool taken)
+    void update(uint32_t, bool taken)
     {
-        int ind = bhr.to_ulong();
-        if(taken)
-        {
-            if(bhrTable[ind].count() == 2) 
-            {
-                //do nothing
-            } //if both are already 1
-            else if(bhrTable[ind][0] == 1) //01 goes to 10
-            {
-                bhrTable[ind][0].flip(); bhrTable[ind][1].flip();
-            }
-            else //00 goes to 01, 10 goes to 11
-            {
-                bhrTable[ind][0].flip(); //updating this bit to 1
-            }
-        }
-        else
-        {
-            if(bhrTable[ind].count() == 0)
-            {
-
-            } //if both are already 0
-            else if(bhrTable[ind][0] == 1) //01 or 11 goes to 00 or 10
-            {
-                bhrTable[ind][0].flip(); //updating this bit to 0
-            }
-            else //10 goes to 01 (00 case is not there as its already taken care of)
-            {
-                bhrTable[ind][0].flip(); bhrTable[ind][1].flip();
-            }
-        }
-
+        bhrTable.update(bhr.to_ulong(), taken);
         bhr[1] = bhr[0]; //moved the 1st bit to 2nd bit, and updated the second bit based on taken
         bhr[0] = (taken)? 1 : 0;
     }
 };
 
+//the saturating and bhr counters blended, the bhr one weighs 3 and the saturating one 7 out of 10 and it predicts taken
+//when the blend is at least 1.5
 struct SaturatingBHRBranchPredictor : public BranchPredictor {
-    std::vector<std::bitset<2>> bhrTable;
+    CounterTable bhrTable;
     std::bitset<2> bhr;
-    std::vector<std::bitset<2>> table;
-    std::vector<std::bitset<2>> combination;
-    SaturatingBHRBranchPredictor(int value, int size) : bhrTable(1 << 2, value), bhr(value), table(1 << 14, value), combination(size, value) {
-        assert(size <= (1 << 16));
+    CounterTable table;
+    uint32_t mask; //the saturating table has size counters, a power of two, indexed by that many lsbs of the pc
+    SaturatingBHRBranchPredictor(int value, int size = 1 << 14) : bhrTable(1 << 2, value), bhr(value), table(size, value), mask(size - 1) {
+        assert(size > 0 && size <= (1 << 24) && (size & (size - 1)) == 0);
     }
 
     bool predict(uint32_t pc) 
     {
-        cout << "yoyo";
-        int ind = (pc & 16383); 
-        int index  = table[ind].to_ulong();
-        double x = 0.3;
-        double y = ((double)(bhrTable[bhr.to_ulong()].to_ulong())*x + (1-x)*((double)index));
-        if(y >= 1.5){
-            return true;
+        //0.3 * bhr + 0.7 * saturating >= 1.5, in tenths
+        return 3 * bhrTable.get(bhr.to_ulong()) + 7 * table.get(pc & mask) >= 15;
+    }
+    void update(uint32_t pc, bool taken) {
+        table.update(pc & mask, taken);
+        bhrTable.update(bhr.to_ulong(), taken);
+        bhr[1] = bhr[0];
+        bhr[0] = taken ? 1: 0;
+    } 
+};
+
+//one table of 2^bits counters indexed by the pc xor the outcomes of the last historyBits branches (the newest in bit 0)
+struct GShareBranchPredictor : public BranchPredictor {
+    CounterTable table;
+    uint32_t mask, history = 0, historyMask;
+    GShareBranchPredictor(int value, int historyBits = 12, int bits = 14) : table(1 << bits, value), mask((1u << bits) - 1),
+        historyMask((1u << historyBits) - 1) {}
+
+    uint32_t index(uint32_t pc) { return (pc ^ history) & mask; }
+    bool predict(uint32_t pc) { return table.taken(index(pc)); }
+    void update(uint32_t pc, bool taken) {
+        table.update(index(pc), taken);
+        history = ((history << 1) | taken) & historyMask;
+    }
+};
+
+//a bimodal table (the saturating predictor) and gshare side by side. A table of 2 bit chooser counters indexed by the pc
+//moves towards whichever of the two was right when they disagree, 2 and 3 trust gshare. The choosers start at 1 so a
+//branch begins on the bimodal side, which needs no history to warm up
+struct TournamentBranchPredictor : public BranchPredictor {
+    SaturatingBranchPredictor bimodal;
+    GShareBranchPredictor gshare;
+    CounterTable chooser;
+    uint32_t mask;
+    TournamentBranchPredictor(int value, int historyBits = 12, int bits = 14) : bimodal(value, bits), gshare(value, historyBits, bits),
+        chooser(1 << bits, 1), mask((1u << bits) - 1) {}
+
+    bool predict(uint32_t pc) {
+        return chooser.taken(pc & mask) ? gshare.predict(pc) : bimodal.predict(pc);
+    }
+    void update(uint32_t pc, bool taken) {
+        bool global = gshare.predict(pc), local = bimodal.predict(pc);
+        if (global != local)
+            chooser.update(pc & mask, global == taken);
+        bimodal.update(pc, taken);
+        gshare.update(pc, taken);
+    }
+};
+
+//a local history component and gshare with a chooser between them, the arrangement of the Alpha 21264. Every branch
+//keeps its own last historyBits outcomes (in a table of 2^bits histories indexed by the pc) and they index a table of
+//2^historyBits counters, which catches loops and patterns of a single branch that the global history smears out
+struct HybridBranchPredictor : public BranchPredictor {
+    vector<uint32_t> localHistory;
+    CounterTable localTable;
+    GShareBranchPredictor gshare;
+    CounterTable chooser;
+    uint32_t mask, historyMask;
+    HybridBranchPredictor(int value, int historyBits = 12, int bits = 14) : localHistory(1 << bits, 0), localTable(1 << historyBits, value),
+        gshare(value, historyBits, bits), chooser(1 << bits, 1), mask((1u << bits) - 1), historyMask((1u << historyBits) - 1) {}
+
+    bool localPredict(uint32_t pc) { return localTable.taken(localHistory[pc & mask]); }
+    bool predict(uint32_t pc) {
+        return chooser.taken(pc & mask) ? gshare.predict(pc) : localPredict(pc);
+    }
+    void update(uint32_t pc, bool taken) {
+        bool global = gshare.predict(pc), local = localPredict(pc);
+        if (global != local)
+            chooser.update(pc & mask, global == taken);
+        uint32_t &history = localHistory[pc & mask];
+        localTable.update(history, taken);
+        history = ((history << 1) | taken) & historyMask;
+        gshare.update(pc, taken);
+    }
+};
+
+//the shape of a TAGE predictor: tables tagged tables of 2^tableBits entries, looked up with histories of minHistory up
+//to maxHistory outcomes in a geometric series, tags of tagBits bits and the usefulness counters aged every 2^resetBits
+//branches
+struct TageConfig {
+    int tables = 4, tableBits = 10, minHistory = 4, maxHistory = 64, tagBits = 9, resetBits = 18;
+};
+
+//TAGE (Seznec and Michaud): a bimodal base table and tagged tables looked up with ever longer global histories, the
+//table with the longest history whose tag matches gives the prediction. Each table sees its history folded down to the
+//width of its index and of its tag, and the folds are kept up to date a bit at a time so a branch costs O(tables) however
+//long the histories get. A misprediction takes an entry in a longer table whose usefulness counter is 0 (or ages those
+//of the longer tables when there is none), and every 2^resetBits branches the high and then the low bits of all the
+//usefulness counters are cleared in turn so entries that stopped helping can be taken again.
+//A pipeline predicts a branch long before the older ones are updated, so predict pushes the predicted direction onto
+//the history straight away and keeps what it looked up for update, which takes the oldest prediction (branches resolve
+//in the order they were predicted) and puts the history right when it was wrong
+struct TageBranchPredictor : public BranchPredictor {
+    static const int MAX_TABLES = 16;
+    struct Entry {
+        int8_t counter = 0; //-4 to 3, 0 and up predict taken
+        uint16_t tag = 0;
+        uint8_t useful = 0; //0 to 3
+    };
+    //the last length outcomes xored down to width bits, updated with the bit coming in and the one falling out. The bit
+    //coming in ends up as bit 0 and nowhere else
+    struct FoldedHistory {
+        uint32_t value = 0;
+        int length = 0, width = 0;
+        void update(uint32_t in, uint32_t out) {
+            value = (value << 1) | in;
+            value ^= out << (length % width);
+            value ^= value >> width;
+            value &= (1u << width) - 1;
         }
-        else{
-            return false;
+    };
+    //what a branch found in the tables: the longest table that hit (-1 for the base table), the next longest and what
+    //they say
+    struct Lookup {
+        uint32_t pc = 0;
+        long long pushed = 0; //the history pushes before its own, -1 when its direction was never pushed
+        int provider = -1, alternate = -1;
+        bool providerTaken = false, alternateTaken = false, prediction = false, fresh = false;
+        uint32_t indices[MAX_TABLES], tags[MAX_TABLES];
+    };
+
+    TageConfig config;
+    CounterTable base;
+    vector<vector<Entry>> tables;
+    vector<int> lengths;
+    vector<FoldedHistory> indexFolds, tagFolds[2];
+    vector<uint8_t> history; //a ring, the outcome i branches ago is at (newest + i) & historyMask
+    uint32_t newest = 0, historyMask, baseMask, tableMask, tagMask;
+    long long pushes = 0, branches = 0;
+    deque<Lookup> pending; //predicted and not updated yet, oldest first
+    int useAltOnNew = 8; //0 to 15, from 8 up a newly taken entry defers to the alternate prediction
+    uint32_t random = 0x2545F491;
+
+    //tables is at most MAX_TABLES, tagBits from 2 to 16 and minHistory at most maxHistory
+    TageBranchPredictor(int value, int baseBits, const TageConfig &c) : config(c), base(1 << baseBits, value),
+        tables(c.tables, vector<Entry>(1 << c.tableBits)), lengths(c.tables), indexFolds(c.tables) {
+        uint32_t ring = 1;
+        while (ring <= (uint32_t)c.maxHistory)
+            ring <<= 1;
+        history.assign(ring, 0);
+        historyMask = ring - 1;
+        baseMask = (1u << baseBits) - 1;
+        tableMask = (1u << c.tableBits) - 1;
+        tagMask = (1u << c.tagBits) - 1;
+        tagFolds[0].resize(c.tables);
+        tagFolds[1].resize(c.tables);
+        for (int t = 0; t < c.tables; ++t) {
+            double ratio = (c.tables == 1) ? 0 : (double)t / (c.tables - 1);
+            lengths[t] = (int)(c.minHistory * pow((double)c.maxHistory / c.minHistory, ratio) + 0.5);
+            indexFolds[t].length = tagFolds[0][t].length = tagFolds[1][t].length = lengths[t];
+            indexFolds[t].width = c.tableBits;
+            tagFolds[0][t].width = c.tagBits;
+            tagFolds[1][t].width = c.tagBits - 1;
         }
-        // if(combination[4*ind + index][1] == 1)
-        //     return true;
-        // else
-        //     return false;
     }
-    void update(uint32_t pc, bool taken) {
-          //cout << "HELLO";
-        int index = (pc & 16383);
-        if(taken)
-        {
-           if(table[index].count() == 2) {} //if both are already 1
-            else if(table[index][0] == 1) //01 goes to 10
-            {
-              
-                table[index][0].flip(); table[index][1].flip();
-            }
-            else //00 goes to 01, 10 goes to 11
-            {
-                table[index][0].flip(); //updating this bit to 1
+
+    Entry &entry(const Lookup &l, int t) { return tables[t][l.indices[t]]; }
+
+    Lookup lookup(uint32_t pc) {
+        Lookup l;
+        l.pc = pc;
+        l.pushed = pushes;
+        for (int t = config.tables - 1; t >= 0; --t) {
+            l.indices[t] = (pc ^ (pc >> config.tableBits) ^ indexFolds[t].value) & tableMask;
+            l.tags[t] = (pc ^ tagFolds[0][t].value ^ (tagFolds[1][t].value << 1)) & tagMask;
+            if (tables[t][l.indices[t]].tag == l.tags[t]) {
+                if (l.provider < 0)
+                    l.provider = t;
+                else if (l.alternate < 0)
+                    l.alternate = t;
             }
+        }
+        bool baseTaken = base.taken(pc & baseMask);
+        l.alternateTaken = (l.alternate >= 0) ? entry(l, l.alternate).counter >= 0 : baseTaken;
+        if (l.provider < 0) {
+            l.prediction = l.providerTaken = baseTaken;
+            return l;
+        }
+        Entry &e = entry(l, l.provider);
+        l.providerTaken = e.counter >= 0;
+        l.fresh = (e.useful == 0 && (e.counter == 0 || e.counter == -1)); //taken lately and not proven yet
+        l.prediction = (l.fresh && useAltOnNew >= 8) ? l.alternateTaken : l.providerTaken;
+        return l;
+    }
+
+    void push(bool taken) {
+        newest = (newest - 1) & historyMask;
+        history[newest] = taken;
+        pushes++;
+        for (int t = 0; t < config.tables; ++t) {
+            uint32_t out = history[(newest + lengths[t]) & historyMask];
+            indexFolds[t].update(taken, out);
+            tagFolds[0][t].update(taken, out);
+            tagFolds[1][t].update(taken, out);
+        }
+    }
 
-            if(bhrTable[bhr.to_ulong()].count() == 2) 
-            {
-                //do nothing
-            } //if both are already 1
-            else if(bhrTable[bhr.to_ulong()][0] == 1) //01 goes to 10
-            {
-                bhrTable[bhr.to_ulong()][0].flip(); bhrTable[bhr.to_ulong()][1].flip();
+    //flips the direction pushed for the branch that made push number pushed
+    void repair(long long pushed) {
+        uint32_t age = (uint32_t)(pushes - 1 - pushed);
+        history[(newest + age) & historyMask] ^= 1;
+        if (age == 0) { //the newest bit is bit 0 of every fold
+            for (int t = 0; t < config.tables; ++t) {
+                indexFolds[t].value ^= 1;
+                tagFolds[0][t].value ^= 1;
+                tagFolds[1][t].value ^= 1;
             }
-            else //00 goes to 01, 10 goes to 11
-            {
-                bhrTable[bhr.to_ulong()][0].flip(); //updating this bit to 1
+            return;
+        }
+        //younger branches were predicted on top of it, fold the histories again from the ring
+        for (int t = 0; t < config.tables; ++t)
+            for (FoldedHistory *fold : {&indexFolds[t], &tagFolds[0][t], &tagFolds[1][t]}) {
+                fold->value = 0;
+                for (int i = fold->length - 1; i >= 0; --i)
+                    fold->update(history[(newest + i) & historyMask], 0);
             }
+    }
+
+    bool predict(uint32_t pc) {
+        pending.push_back(lookup(pc));
+        push(pending.back().prediction);
+        return pending.back().prediction;
+    }
+
+    void update(uint32_t pc, bool taken) {
+        Lookup l;
+        if (!pending.empty() && pending.front().pc == pc) {
+            l = pending.front();
+            pending.pop_front();
+        }
+        else { //it was not predicted, or not in this order
+            pending.clear();
+            l = lookup(pc);
+            l.pushed = -1;
+        }
+        if (l.provider >= 0) {
+            Entry &e = entry(l, l.provider);
+            if (l.fresh && l.providerTaken != l.alternateTaken)
+                useAltOnNew += (l.alternateTaken == taken) ? (useAltOnNew < 15) : -(useAltOnNew > 0);
+            if (l.providerTaken != l.alternateTaken)
+                e.useful += (l.providerTaken == taken) ? (e.useful < 3) : -(e.useful > 0);
+            e.counter += taken ? (e.counter < 3) : -(e.counter > -4);
+            if (l.fresh && l.alternate < 0)
+                base.update(pc & baseMask, taken);
         }
         else
-        {
-            if(table[index].count() == 0) {} //if both are already 0 return s the number bit whih are set
-            else if(table[index][0] == 1) //01 or 11 goes to 00 or 10
-            {
-                table[index][0].flip(); //updating this bit to 0
-            }
-            else //10 goes to 01 (00 case is not there as its already taken care of)
-            {
-                table[index][0].flip(); table[index][1].flip();
+            base.update(pc & baseMask, taken);
+        if (l.prediction != taken && l.provider < config.tables - 1)
+            allocate(l, taken);
+        if (++branches % (1LL << config.resetBits) == 0) {
+            uint8_t keep = ((branches >> config.resetBits) & 1) ? 1 : 2; //the high bits first
+            for (vector<Entry> &table : tables)
+                for (Entry &e : table)
+                    e.useful &= keep;
+        }
+        if (l.pushed < 0)
+            push(taken);
+        else if (l.prediction != taken && pushes - l.pushed <= (long long)historyMask)
+            repair(l.pushed);
+    }
+
+    //an entry for the branch in a table with a longer history than the provider, the one after the provider half of the
+    //time and the one after that otherwise, so branches do not all pile into the same table
+    void allocate(const Lookup &l, bool taken) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        int first = l.provider + 1;
+        if (first < config.tables - 1 && (random & 1))
+            first++;
+        for (int t = first; t < config.tables; ++t)
+            if (entry(l, t).useful == 0) {
+                Entry &e = entry(l, t);
+                e.counter = taken ? 0 : -1;
+                e.tag = l.tags[t];
+                return;
             }
+        for (int t = l.provider + 1; t < config.tables; ++t)
+            if (entry(l, t).useful > 0)
+                entry(l, t).useful--;
+    }
+};
 
-            if(bhrTable[bhr.to_ulong()].count() == 0)
-            {
+//the kernels of the perceptron predictor: the dot product of n weights with n history entries of +1 or -1, and the
+//training step that moves every weight one towards the history (taken) or away from it, staying within -127 to 127.
+//n is a multiple of 32. The SSE4.1 and AVX2 versions are compiled for their instruction set whatever the flags of the
+//build and picked at run time when the processor has it
+inline int perceptronDot(const int8_t *weights, const int8_t *history, int n) {
+    int sum = 0;
+    for (int i = 0; i < n; ++i)
+        sum += weights[i] * history[i];
+    return sum;
+}
 
-            } //if both are already 0
-            else if(bhrTable[bhr.to_ulong()][0] == 1) //01 or 11 goes to 00 or 10
-            {
-                bhrTable[bhr.to_ulong()][0].flip(); //updating this bit to 0
-            }
-            else //10 goes to 01 (00 case is not there as its already taken care of)
-            {
-                bhrTable[bhr.to_ulong()][0].flip(); bhrTable[bhr.to_ulong()][1].flip();
-            }
+inline void perceptronTrain(int8_t *weights, const int8_t *history, int n, bool taken) {
+    for (int i = 0; i < n; ++i)
+        weights[i] = (int8_t)max(-127, min(127, weights[i] + (taken ? history[i] : -history[i])));
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PERCEPTRON_SIMD
+#include <immintrin.h>
+
+//the history entries are +1 or -1 so sign_epi8 multiplies by them, maddubs and madd then widen the products to 32 bits
+__attribute__((target("sse4.1"))) inline int perceptronDotSSE(const int8_t *weights, const int8_t *history, int n) {
+    __m128i sum = _mm_setzero_si128(), ones8 = _mm_set1_epi8(1), ones16 = _mm_set1_epi16(1);
+    for (int i = 0; i < n; i += 16) {
+        __m128i products = _mm_sign_epi8(_mm_loadu_si128((const __m128i *)(weights + i)), _mm_loadu_si128((const __m128i *)(history + i)));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(ones8, products), ones16));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("sse4.1"))) inline void perceptronTrainSSE(int8_t *weights, const int8_t *history, int n, bool taken) {
+    __m128i direction = _mm_set1_epi8(taken ? 1 : -1), low = _mm_set1_epi8(-127);
+    for (int i = 0; i < n; i += 16) {
+        __m128i w = _mm_loadu_si128((const __m128i *)(weights + i));
+        __m128i step = _mm_sign_epi8(_mm_loadu_si128((const __m128i *)(history + i)), direction);
+        _mm_storeu_si128((__m128i *)(weights + i), _mm_max_epi8(_mm_adds_epi8(w, step), low));
+    }
+}
+
+__attribute__((target("avx2"))) inline int perceptronDotAVX2(const int8_t *weights, const int8_t *history, int n) {
+    __m256i sum = _mm256_setzero_si256(), ones8 = _mm256_set1_epi8(1), ones16 = _mm256_set1_epi16(1);
+    for (int i = 0; i < n; i += 32) {
+        __m256i products = _mm256_sign_epi8(_mm256_loadu_si256((const __m256i *)(weights + i)),
+            _mm256_loadu_si256((const __m256i *)(history + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(ones8, products), ones16));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    return _mm_cvtsi128_si32(half);
+}
+
+__attribute__((target("avx2"))) inline void perceptronTrainAVX2(int8_t *weights, const int8_t *history, int n, bool taken) {
+    __m256i direction = _mm256_set1_epi8(taken ? 1 : -1), low = _mm256_set1_epi8(-127);
+    for (int i = 0; i < n; i += 32) {
+        __m256i w = _mm256_loadu_si256((const __m256i *)(weights + i));
+        __m256i step = _mm256_sign_epi8(_mm256_loadu_si256((const __m256i *)(history + i)), direction);
+        _mm256_storeu_si256((__m256i *)(weights + i), _mm256_max_epi8(_mm256_adds_epi8(w, step), low));
+    }
+}
+#endif
+
+//the perceptron predictor (Jimenez and Lin): 2^bits rows of signed 8 bit weights indexed by the pc, one per bit of the
+//global history and a bias. It predicts taken when the bias plus the dot product of the weights with the history (taken
+//as +1, not taken as -1) is at least 0, and trains the row when it was wrong or the sum was within the threshold
+//1.93 * historyBits + 14. historyBits is rounded up to a multiple of 32.
+//The history is a ring with a copy of its start after its end so the window of any branch is contiguous for the
+//kernels. Like TAGE it pushes the predicted direction when it predicts and update puts it right, the ring is longer
+//than the history so the window a branch was predicted with is still there when it trains
+struct PerceptronBranchPredictor : public BranchPredictor {
+    static const int SLACK = 256; //branches that can be predicted and not updated yet with their window kept
+    struct Lookup {
+        uint32_t pc;
+        long long seen; //the pushes before it predicted, its window starts at the newest of them
+        int output;
+    };
+    int historyBits, threshold;
+    uint32_t mask;
+    vector<int8_t> weights, bias;
+    vector<int8_t> history;
+    uint32_t ring;
+    long long pushes = 0;
+    deque<Lookup> pending;
+    int (*dot)(const int8_t *, const int8_t *, int) = perceptronDot;
+    void (*learn)(int8_t *, const int8_t *, int, bool) = perceptronTrain;
+    const char *kernel = "scalar";
+
+    static const size_t MAX_WEIGHTS = (size_t)1 << 28; //bytes of weights, the configs check against fits()
+
+    //whether 2^bits rows of history weights (rounded up like the constructor does) stay within MAX_WEIGHTS
+    static bool fits(int bits, int history) {
+        return ((size_t)(history + 31) / 32 * 32 << bits) <= MAX_WEIGHTS;
+    }
+
+    PerceptronBranchPredictor(int bits = 10, int history = 64, bool simd = true) : historyBits((history + 31) / 32 * 32),
+        threshold(193 * historyBits / 100 + 14), mask((1u << bits) - 1), weights((size_t)historyBits << bits, 0),
+        bias(1 << bits, 0), ring(historyBits + SLACK) {
+        assert(fits(bits, history));
+        this->history.assign(ring + historyBits, -1);
+#ifdef PERCEPTRON_SIMD
+        if (simd && __builtin_cpu_supports("avx2"))
+            dot = perceptronDotAVX2, learn = perceptronTrainAVX2, kernel = "avx2";
+        else if (simd && __builtin_cpu_supports("sse4.1"))
+            dot = perceptronDotSSE, learn = perceptronTrainSSE, kernel = "sse4.1";
+#endif
+    }
+
+    //where push number k went, they go down the ring
+    uint32_t position(long long k) { return (uint32_t)((ring - k % ring) % ring); }
+
+    void push(bool taken) {
+        uint32_t at = position(++pushes);
+        history[at] = taken ? 1 : -1;
+        if (at < (uint32_t)historyBits)
+            history[at + ring] = history[at];
+    }
+
+    int output(uint32_t pc, long long seen) {
+        uint32_t row = pc & mask;
+        return bias[row] + dot(&weights[(size_t)row * historyBits], &history[position(seen)], historyBits);
+    }
+
+    bool predict(uint32_t pc) {
+        pending.push_back({pc, pushes, output(pc, pushes)});
+        push(pending.back().output >= 0);
+        return pending.back().output >= 0;
+    }
+
+    void update(uint32_t pc, bool taken) {
+        Lookup l;
+        bool pushed = !pending.empty() && pending.front().pc == pc;
+        if (pushed) {
+            l = pending.front();
+            pending.pop_front();
         }
-        bhr[1] = bhr[0];
-        bhr[0] = taken ? 1: 0;
-    } 
+        else { //it was not predicted, or not in this order
+            pending.clear();
+            l = {pc, pushes, output(pc, pushes)};
+        }
+        bool wrong = (l.output >= 0) != taken;
+        bool kept = (pushes - l.seen <= SLACK); //its window was not overwritten
+        if ((wrong || abs(l.output) <= threshold) && kept) {
+            uint32_t row = pc & mask;
+            learn(&weights[(size_t)row * historyBits], &history[position(l.seen)], historyBits, taken);
+            bias[row] = (int8_t)max(-127, min(127, bias[row] + (taken ? 1 : -1)));
+        }
+        if (!pushed)
+            push(taken);
+        else if (wrong && kept) {
+            uint32_t at = position(l.seen + 1);
+            history[at] = -history[at];
+            if (at < (uint32_t)historyBits)
+                history[at + ring] = history[at];
+        }
+    }
 };
 
+//the predictor a name stands for: not_taken, saturating, bhr, saturating_bhr, gshare, tournament, hybrid, tage or
+//perceptron, with its counters starting in state counter (the base table of tage has 2^tableBits of them, the
+//perceptron has 2^tableBits rows of weights and a history of historyBits), nullptr for any other name
+BranchPredictor *makeBranchPredictor(const string &type, int counter, int tableBits = 14, int historyBits = 12,
+    const TageConfig &tage = TageConfig()) {
+    if (type == "not_taken")
+        return new StaticBranchPredictor();
+    if (type == "saturating")
+        return new SaturatingBranchPredictor(counter, tableBits);
+    if (type == "bhr")
+        return new BHRBranchPredictor(counter);
+    if (type == "saturating_bhr")
+        return new SaturatingBHRBranchPredictor(counter, 1 << tableBits);
+    if (type == "gshare")
+        return new GShareBranchPredictor(counter, historyBits, tableBits);
+    if (type == "tournament")
+        return new TournamentBranchPredictor(counter, historyBits, tableBits);
+    if (type == "hybrid")
+        return new HybridBranchPredictor(counter, historyBits, tableBits);
+    if (type == "tage")
+        return new TageBranchPredictor(counter, tableBits, tage);
+    if (type == "perceptron")
+        return new PerceptronBranchPredictor(tableBits, historyBits);
+    return nullptr;
+}
+
+//remembers where the jumps and taken branches fetched before went, so fetch can follow them in the next cycle instead
+//of waiting for decode. The entries are split into sets of ways indexed by the low bits of the pc and told apart by
+//tagBits bits above those (LRU within a set). With too few tag bits two commands share an entry and fetch may be sent
+//to the target of the other one, or away from a command that is no jump at all
+struct BranchTargetBuffer {
+    struct Entry {
+        bool valid = false;
+        uint32_t tag = 0;
+        int target = 0;
+        uint64_t used = 0;
+    };
+    vector<Entry> entries;
+    uint32_t sets, ways, indexBits, tagMask;
+    uint64_t time = 0;
+    long long lookups = 0, hits = 0;
+
+    //entries and ways are powers of two, ways at most entries and tagBits at most 30
+    BranchTargetBuffer(int entryCount, int wayCount, int tagBits) : entries(entryCount), sets(entryCount / wayCount), ways(wayCount),
+        indexBits(__builtin_ctz(entryCount / wayCount)), tagMask((1u << tagBits) - 1) {}
+
+    Entry *find(uint32_t pc) {
+        Entry *set = &entries[(pc & (sets - 1)) * ways];
+        uint32_t tag = (pc >> indexBits) & tagMask;
+        for (uint32_t way = 0; way < ways; ++way)
+            if (set[way].valid && set[way].tag == tag)
+                return &set[way];
+        return nullptr;
+    }
+
+    //the target fetch should go to after pc, false if there is none
+    bool lookup(uint32_t pc, int &target) {
+        lookups++;
+        Entry *entry = find(pc);
+        if (!entry)
+            return false;
+        hits++;
+        entry->used = ++time;
+        target = entry->target;
+        return true;
+    }
+
+    void update(uint32_t pc, int target) {
+        Entry *entry = find(pc);
+        if (!entry) { //the least recently used way of the set, an empty one first
+            Entry *set = &entries[(pc & (sets - 1)) * ways];
+            entry = set;
+            for (uint32_t way = 1; way < ways && entry->valid; ++way)
+                if (!set[way].valid || set[way].used < entry->used)
+                    entry = &set[way];
+        }
+        entry->valid = true;
+        entry->tag = (pc >> indexBits) & tagMask;
+        entry->target = target;
+        entry->used = ++time;
+    }
 
+    //drops the entry that matched pc, once decode finds out it sent fetch the wrong way
+    void erase(uint32_t pc) {
+        if (Entry *entry = find(pc))
+            entry->valid = false;
+    }
+};
 
 #endif
\ No newline at end of file
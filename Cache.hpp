@@ -0,0 +1,338 @@
+#ifndef __CACHE_HPP__
+#define __CACHE_HPP__
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdint>
+
+//L1 instruction and data caches in front of a memory that takes a fixed number of cycles for every access. A pipeline
+//asks how many cycles a fetch, load or store takes and stalls for them, the values themselves still come from
+//MIPS_Architecture::data, the caches only keep the tags needed to tell a hit from a miss.
+//	- a hit takes hit_latency cycles, a miss memory_latency more to bring the line in, and memory_latency more again when
+//	  the line it replaces is dirty and has to be written back first
+//	- a write back cache marks the line dirty, a write through one sends every store on to memory and the store waits
+//	  for it (there is no write buffer). Without write allocate a store that misses goes to memory and leaves the cache
+//	  as it was
+//	- a cache of size 0 is left out, every access to it goes to memory
+struct CacheConfig
+{
+	enum Replacement
+	{
+		LRU,
+		PLRU, //tree pseudo LRU
+		RANDOM
+	};
+	static const int MAX_SIZE = 1 << 30, MAX_LINE = 4096, MAX_WAYS = 64, MAX_LATENCY = 100000;
+	int size = 0, lineSize = 32, ways = 1; //sizes in bytes, all powers of two
+	int hitLatency = 1;
+	Replacement replacement = LRU;
+	bool writeBack = true, writeAllocate = true;
+
+	static bool number(const std::string &value, int low, int high, int &out)
+	{
+		if (value.empty() || value.size() > 10 || value.find_first_not_of("0123456789") != std::string::npos)
+			return false;
+		long long n = std::stoll(value);
+		out = (int)n;
+		return n >= low && n <= high;
+	}
+
+	static bool powerOfTwo(int n)
+	{
+		return n > 0 && (n & (n - 1)) == 0;
+	}
+
+	//key is a key of the config file without its icache_ or dcache_
+	bool set(const std::string &key, const std::string &value)
+	{
+		if (key == "size")
+			return number(value, 0, MAX_SIZE, size) && (size == 0 || powerOfTwo(size));
+		if (key == "line")
+			return number(value, 4, MAX_LINE, lineSize) && powerOfTwo(lineSize);
+		if (key == "ways")
+			return number(value, 1, MAX_WAYS, ways) && powerOfTwo(ways);
+		if (key == "hit_latency")
+			return number(value, 1, MAX_LATENCY, hitLatency);
+		if (key == "replacement")
+		{
+			replacement = (value == "lru") ? LRU : (value == "plru") ? PLRU : RANDOM;
+			return value == "lru" || value == "plru" || value == "random";
+		}
+		if (key == "write")
+		{
+			writeBack = (value == "back");
+			return value == "back" || value == "through";
+		}
+		if (key == "write_allocate")
+		{
+			writeAllocate = (value == "on" || value == "1");
+			return value == "on" || value == "off" || value == "1" || value == "0";
+		}
+		return false;
+	}
+
+	//4096 bytes, 2 way, 32 byte lines, lru
+	std::string describe(bool writes) const
+	{
+		if (size == 0)
+			return "none";
+		static const char *names[] = {"lru", "plru", "random"};
+		std::string text = std::to_string(size) + " bytes, " + std::to_string(ways) + " way, " + std::to_string(lineSize) +
+			" byte lines, " + names[replacement];
+		if (writes)
+		{
+			text += writeBack ? ", write back" : ", write through";
+			text += writeAllocate ? ", write allocate" : ", no write allocate";
+		}
+		return text;
+	}
+};
+
+struct Cache
+{
+	struct Line
+	{
+		uint32_t line = 0; //the byte address divided by the line size
+		bool valid = false, dirty = false;
+		uint64_t used = 0; //when it was last used, for LRU
+	};
+
+	CacheConfig config;
+	uint32_t sets = 0;
+	int lineBits = 0;
+	std::vector<Line> lines; //ways of them for each set
+	std::vector<uint64_t> tree; //the pseudo LRU bits of each set, bit n is node n of a heap over the ways
+	uint64_t time = 0, random = 0;
+	long long reads = 0, writes = 0, readMisses = 0, writeMisses = 0, writebacks = 0;
+
+	void configure(const CacheConfig &c)
+	{
+		config = c;
+		sets = (config.size == 0) ? 0 : config.size / (config.lineSize * config.ways);
+		lineBits = __builtin_ctz(config.lineSize);
+		clear();
+	}
+
+	bool present() const
+	{
+		return sets > 0;
+	}
+
+	//empty, with the counts at zero
+	void clear()
+	{
+		lines.assign((size_t)sets * config.ways, Line());
+		tree.assign(sets, 0);
+		time = 0;
+		random = 0x9E3779B97F4A7C15ULL; //the same evictions every run
+		reads = writes = readMisses = writeMisses = writebacks = 0;
+	}
+
+	//looks up the line of a byte address, and brings it in on a miss unless it is a store without write allocate.
+	//Returns whether it hit, evicted is set when a dirty line was written back to make room
+	bool access(uint32_t address, bool write, bool &evicted)
+	{
+		evicted = false;
+		(write ? writes : reads)++;
+		uint32_t line = address >> lineBits, set = line & (sets - 1);
+		Line *ways = &lines[(size_t)set * config.ways];
+		for (int way = 0; way < config.ways; ++way)
+			if (ways[way].valid && ways[way].line == line)
+			{
+				ways[way].dirty |= write && config.writeBack;
+				touch(set, way);
+				return true;
+			}
+		(write ? writeMisses : readMisses)++;
+		if (write && !config.writeAllocate)
+			return false;
+		int way = victim(set);
+		evicted = ways[way].valid && ways[way].dirty;
+		writebacks += evicted;
+		ways[way].line = line;
+		ways[way].valid = true;
+		ways[way].dirty = write && config.writeBack;
+		touch(set, way);
+		return false;
+	}
+
+	//the way of set a new line goes into, an empty one if there is one
+	int victim(uint32_t set)
+	{
+		Line *ways = &lines[(size_t)set * config.ways];
+		for (int way = 0; way < config.ways; ++way)
+			if (!ways[way].valid)
+				return way;
+		switch (config.replacement)
+		{
+		case CacheConfig::LRU:
+		{
+			int oldest = 0;
+			for (int way = 1; way < config.ways; ++way)
+				if (ways[way].used < ways[oldest].used)
+					oldest = way;
+			return oldest;
+		}
+		case CacheConfig::PLRU:
+		{
+			int node = 0; //follow the bits down, 1 is the right half
+			while (node < config.ways - 1)
+				node = 2 * node + 1 + (tree[set] >> node & 1);
+			return node - (config.ways - 1);
+		}
+		default: //xorshift
+			random ^= random << 13;
+			random ^= random >> 7;
+			random ^= random << 17;
+			return random & (config.ways - 1);
+		}
+	}
+
+	void touch(uint32_t set, int way)
+	{
+		lines[(size_t)set * config.ways + way].used = ++time;
+		//every node above the way points to the other half
+		for (int node = way + config.ways - 1; node > 0; node = (node - 1) / 2)
+		{
+			int parent = (node - 1) / 2;
+			if (node == 2 * parent + 2)
+				tree[set] &= ~(1ULL << parent);
+			else
+				tree[set] |= 1ULL << parent;
+		}
+	}
+};
+
+//the caches a pipeline runs with, read from a config file (see caches.cfg)
+struct MemoryHierarchy
+{
+	bool enabled = false; //without a config every access takes a single cycle, the way the pipelines always worked
+	int memoryLatency = 100;
+	Cache instructions, data;
+	long long memoryAccesses = 0;
+
+	//lines of key = value, # starts a comment, the keys are memory_latency and icache_ or dcache_ followed by a key of
+	//CacheConfig::set. Returns false (after saying what is wrong) if the file can not be read or has a key it does not
+	//know or a value out of range, the keys that are not given keep their defaults
+	bool load(const std::string &fileName)
+	{
+		std::ifstream file(fileName);
+		if (!file.is_open())
+		{
+			std::cerr << "Cache config " << fileName << " could not be opened\n";
+			return false;
+		}
+		CacheConfig configs[2];
+		std::string line;
+		for (int number = 1; getline(file, line); ++number)
+		{
+			line = line.substr(0, line.find('#'));
+			for (char &c : line)
+				if (c == '=')
+					c = ' ';
+			std::istringstream words(line);
+			std::string key, value, extra;
+			if (!(words >> key))
+				continue;
+			bool ok = (words >> value) && !(words >> extra);
+			if (ok && key == "memory_latency")
+				ok = CacheConfig::number(value, 1, CacheConfig::MAX_LATENCY, memoryLatency);
+			else if (ok && (key.substr(0, 7) == "icache_" || key.substr(0, 7) == "dcache_"))
+				ok = configs[key[0] == 'd'].set(key.substr(7), value);
+			else
+				ok = false;
+			if (!ok)
+			{
+				std::cerr << "Line " << number << " of cache config " << fileName << ": expected one of\n"
+						  << "\tmemory_latency, icache_hit_latency, dcache_hit_latency = 1 to " << CacheConfig::MAX_LATENCY << "\n"
+						  << "\ticache_size, dcache_size = 0 or a power of two up to " << CacheConfig::MAX_SIZE << "\n"
+						  << "\ticache_line, dcache_line = a power of two from 4 to " << CacheConfig::MAX_LINE << "\n"
+						  << "\ticache_ways, dcache_ways = a power of two up to " << CacheConfig::MAX_WAYS << "\n"
+						  << "\ticache_replacement, dcache_replacement = lru, plru or random\n"
+						  << "\tdcache_write = back or through, dcache_write_allocate = on or off\n";
+				return false;
+			}
+		}
+		for (CacheConfig &c : configs)
+			if (c.size != 0 && c.size < c.lineSize * c.ways)
+			{
+				std::cerr << "Cache config " << fileName << ": a cache of " << c.size << " bytes can not hold " << c.ways
+						  << " ways of " << c.lineSize << " byte lines\n";
+				return false;
+			}
+		instructions.configure(configs[0]);
+		data.configure(configs[1]);
+		enabled = true;
+		memoryAccesses = 0;
+		return true;
+	}
+
+	//the cycles it takes to fetch command number pc
+	int fetch(int pc)
+	{
+		return enabled ? access(instructions, 4 * (uint32_t)pc, false) : 1;
+	}
+	//the cycles it takes to load or store a word, the address is in words
+	int read(uint32_t word)
+	{
+		return enabled ? access(data, word << 2, false) : 1;
+	}
+	int write(uint32_t word)
+	{
+		return enabled ? access(data, word << 2, true) : 1;
+	}
+
+	int access(Cache &cache, uint32_t address, bool write)
+	{
+		if (!cache.present())
+		{
+			memoryAccesses++;
+			return memoryLatency;
+		}
+		bool evicted;
+		bool hit = cache.access(address, write, evicted);
+		int transfers = !hit + evicted; //the line brought in (or the word stored around the cache) and the one written back
+		if (write && !cache.config.writeBack && (hit || cache.config.writeAllocate))
+			transfers++; //written through
+		memoryAccesses += transfers;
+		return cache.config.hitLatency + transfers * memoryLatency;
+	}
+
+	//empties the caches and zeroes the counts, the configuration stays
+	void clear()
+	{
+		instructions.clear();
+		data.clear();
+		memoryAccesses = 0;
+	}
+
+	void report(std::ostream &out) const
+	{
+		auto percent = [](long long part, long long whole)
+		{
+			std::ostringstream text;
+			text.precision(2);
+			text << std::fixed << (whole == 0 ? 0.0 : 100.0 * part / whole) << '%';
+			return text.str();
+		};
+		out << "\nL1 instruction cache (" << instructions.config.describe(false) << "): ";
+		if (instructions.present())
+			out << instructions.reads << " fetches, " << instructions.readMisses << " misses ("
+				<< percent(instructions.readMisses, instructions.reads) << ")\n";
+		else
+			out << "every fetch goes to memory\n";
+		out << "L1 data cache (" << data.config.describe(true) << "): ";
+		if (data.present())
+			out << data.reads << " loads, " << data.readMisses << " misses (" << percent(data.readMisses, data.reads)
+				<< "), " << data.writes << " stores, " << data.writeMisses << " misses (" << percent(data.writeMisses, data.writes)
+				<< "), " << data.writebacks << " lines written back\n";
+		else
+			out << "every load and store goes to memory\n";
+		out << "Memory (" << memoryLatency << " cycles): " << memoryAccesses << " accesses\n";
+	}
+};
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef __CHECKPOINT_HPP__
+#define __CHECKPOINT_HPP__
+
+#include <MIPS_Processor.hpp>
+#include <cstring>
+
+//binary checkpoints of the architectural state, so that a run can start from the middle of a program instead of
+//executing everything before it again. The layout is (all little endian, as written by the host):
+//	"MIPSCKPT", version, fingerprint of the decoded program, PCcurr, PCnext, the 32 registers,
+//	commandCount (size then values), then the non-zero runs of data as (first word, number of words, words...)
+//	ending with a run of length 0
+//the fingerprint makes sure a checkpoint is only ever restored into the program it was taken from.
+namespace Checkpoint
+{
+	static const char magic[8] = {'M', 'I', 'P', 'S', 'C', 'K', 'P', 'T'};
+	static const uint32_t version = 1;
+
+	//FNV-1a over the fields of the decoded program
+	inline uint64_t fingerprint(const std::vector<Instruction> &program)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		auto mix = [&hash](int64_t value)
+		{
+			for (int i = 0; i < 8; ++i, value >>= 8)
+				hash = (hash ^ (value & 0xff)) * 1099511628211ULL;
+		};
+		mix(program.size());
+		for (auto &ins : program)
+		{
+			mix(ins.op); mix(ins.r[0]); mix(ins.r[1]); mix(ins.r[2]); mix(ins.imm); mix(ins.target);
+		}
+		return hash;
+	}
+
+	template <typename T>
+	void put(std::ofstream &out, T value)
+	{
+		out.write((const char *)&value, sizeof(T));
+	}
+	template <typename T>
+	bool get(std::ifstream &in, T &value)
+	{
+		return (bool)in.read((char *)&value, sizeof(T));
+	}
+
+	//returns false (with a message on cerr) if the file could not be written
+	bool save(MIPS_Architecture *arch, const std::string &fileName)
+	{
+		std::ofstream out(fileName, std::ios::binary);
+		if (!out.is_open())
+		{
+			std::cerr << "Could not open checkpoint " << fileName << " for writing\n";
+			return false;
+		}
+		out.write(magic, sizeof(magic));
+		put(out, version);
+		put(out, fingerprint(arch->program));
+		put<int32_t>(out, arch->PCcurr);
+		put<int32_t>(out, arch->PCnext);
+		out.write((const char *)arch->registers, sizeof(arch->registers));
+		put<uint32_t>(out, arch->commandCount.size());
+		out.write((const char *)arch->commandCount.data(), arch->commandCount.size() * sizeof(int));
+		for (uint32_t number : arch->data.sortedPages()) //runs are split at page boundaries, which load does not mind
+		{
+			const int *page = arch->data.page(number);
+			for (uint32_t i = 0; i < PagedMemory::PAGE_WORDS;)
+			{
+				if (page[i] == 0)
+				{
+					++i;
+					continue;
+				}
+				uint32_t j = i;
+				while (j < PagedMemory::PAGE_WORDS && page[j] != 0)
+					++j;
+				put<uint32_t>(out, (number << PagedMemory::PAGE_BITS) + i);
+				put<uint32_t>(out, j - i);
+				out.write((const char *)(page + i), (j - i) * sizeof(int));
+				i = j;
+			}
+		}
+		put<uint32_t>(out, 0);
+		put<uint32_t>(out, 0);
+		if (!out)
+		{
+			std::cerr << "Could not write checkpoint " << fileName << '\n';
+			return false;
+		}
+		return true;
+	}
+
+	//restores the state saved by save into arch, which must hold the same program.
+	//returns false (with a message on cerr) and leaves arch untouched if the checkpoint can not be used
+	bool load(MIPS_Architecture *arch, const std::string &fileName)
+	{
+		std::ifstream in(fileName, std::ios::binary);
+		if (!in.is_open())
+		{
+			std::cerr << "Could not open checkpoint " << fileName << '\n';
+			return false;
+		}
+		char fileMagic[8];
+		uint32_t fileVersion, countSize;
+		uint64_t fileFingerprint;
+		int32_t PCcurr, PCnext;
+		int registers[32];
+		if (!in.read(fileMagic, sizeof(fileMagic)) || memcmp(fileMagic, magic, sizeof(magic)) != 0 || !get(in, fileVersion) || fileVersion != version)
+		{
+			std::cerr << fileName << " is not a checkpoint of this version\n";
+			return false;
+		}
+		if (!get(in, fileFingerprint) || fileFingerprint != fingerprint(arch->program))
+		{
+			std::cerr << "Checkpoint " << fileName << " was taken from a different program\n";
+			return false;
+		}
+		std::vector<int> commandCount;
+		bool ok = get(in, PCcurr) && get(in, PCnext) && in.read((char *)registers, sizeof(registers)) && get(in, countSize) && countSize == arch->commandCount.size();
+		if (ok)
+		{
+			commandCount.resize(countSize);
+			ok = (bool)in.read((char *)commandCount.data(), countSize * sizeof(int));
+		}
+		//the data runs are read into a copy first so that a truncated file does not leave a half restored memory
+		std::vector<std::pair<uint32_t, std::vector<int>>> runs;
+		while (ok)
+		{
+			uint32_t first, length;
+			ok = get(in, first) && get(in, length);
+			if (!ok || length == 0)
+				break;
+			if ((uint64_t)first + length > (uint64_t)PagedMemory::WORD_MASK + 1)
+			{
+				ok = false;
+				break;
+			}
+			runs.push_back({first, std::vector<int>(length)});
+			ok = (bool)in.read((char *)runs.back().second.data(), length * sizeof(int));
+		}
+		if (!ok)
+		{
+			std::cerr << "Checkpoint " << fileName << " is truncated or corrupt\n";
+			return false;
+		}
+
+		arch->PCcurr = PCcurr;
+		arch->PCnext = PCnext;
+		memcpy(arch->registers, registers, sizeof(registers));
+		arch->commandCount = commandCount;
+		arch->data.clear();
+		for (auto &run : runs)
+			for (uint32_t i = 0; i < run.second.size(); ++i)
+				arch->data.write(run.first + i, run.second[i]);
+		return true;
+	}
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef __FUNCTIONAL_MODEL_HPP__
+#define __FUNCTIONAL_MODEL_HPP__
+
+#include <MIPS_Processor.hpp>
+#include <climits>
+
+//define FUNCTIONAL_SWITCH_DISPATCH to use a plain switch instead of computed gotos (for compilers without the gnu extension)
+#if defined(__GNUC__) && !defined(FUNCTIONAL_SWITCH_DISPATCH)
+#define FUNCTIONAL_THREADED 1
+#else
+#define FUNCTIONAL_THREADED 0
+#endif
+
+//the non pipelined golden model. It executes the decoded program one instruction at a time with no notion of stages,
+//so it gives the final registers, data memory and commandCount of a program much faster than any of the pipelines.
+//run() can also be stopped after a given number of instructions and resumed later, which is what fast forwarding uses.
+struct FunctionalModel
+{
+	//one slot of the direct threaded code, handler is the address of the code that executes ins
+	struct ThreadedInstruction
+	{
+		const void *handler;
+		Instruction ins;
+	};
+
+	MIPS_Architecture *arch;
+	std::vector<ThreadedInstruction> code; //program.size() + 1 slots, the last one ends the program
+	long long instructionsExecuted = 0;
+
+	FunctionalModel(MIPS_Architecture *architecture)
+	{
+		arch = architecture;
+	}
+
+	//executes at most maxInstructions instructions starting from arch->PCnext (all of them if maxInstructions < 0).
+	//on return arch->PCnext is the next instruction to execute, returns one of the exit codes
+	int run(long long maxInstructions = -1)
+	{
+		int *R = arch->registers, *count = arch->commandCount.data();
+		PagedMemory &data = arch->data;
+		uint64_t addressLimit = arch->addressLimit;
+		int size = arch->program.size(), pc = arch->PCnext, exitCode = MIPS_Architecture::SUCCESS;
+		long long executed = instructionsExecuted;
+		long long limit = (maxInstructions < 0) ? LLONG_MAX : executed + maxInstructions;
+		const ThreadedInstruction *t;
+		if (pc < 0 || pc > size)
+			pc = size;
+
+#if FUNCTIONAL_THREADED
+		//indexed by opcode, OP_NOP is only ever found in the slot past the end of the program
+		static const void *const handlers[] = {&&L_END, &&L_ADD, &&L_SUB, &&L_MUL, &&L_AND, &&L_OR, &&L_SLT,
+			&&L_ADDI, &&L_ANDI, &&L_ORI, &&L_SRL, &&L_SLL, &&L_LW, &&L_SW, &&L_BEQ, &&L_BNE, &&L_J};
+		if (code.size() != arch->program.size() + 1)
+			translate(handlers);
+#define CASE(op, label) label:
+#define DISPATCH() do { if (executed == limit) goto stop; t = &code[pc]; goto *t->handler; } while (0)
+#else
+		if (code.size() != arch->program.size() + 1)
+			translate(nullptr);
+#define CASE(op, label) case op:
+#define DISPATCH() do { if (executed == limit) goto stop; t = &code[pc]; goto dispatch; } while (0)
+#endif
+#define BEGIN() (++executed, ++count[pc])
+#define A t->ins.r[0]
+#define B t->ins.r[1]
+#define C t->ins.r[2]
+
+		DISPATCH();
+#if !FUNCTIONAL_THREADED
+	dispatch:
+		switch (t->ins.op)
+		{
+#endif
+		CASE(OP_ADD, L_ADD) BEGIN(); R[A] = R[B] + R[C]; pc++; DISPATCH();
+		CASE(OP_SUB, L_SUB) BEGIN(); R[A] = R[B] - R[C]; pc++; DISPATCH();
+		CASE(OP_MUL, L_MUL) BEGIN(); R[A] = R[B] * R[C]; pc++; DISPATCH();
+		CASE(OP_AND, L_AND) BEGIN(); R[A] = R[B] & R[C]; pc++; DISPATCH();
+		CASE(OP_OR, L_OR) BEGIN(); R[A] = R[B] | R[C]; pc++; DISPATCH();
+		CASE(OP_SLT, L_SLT) BEGIN(); R[A] = R[B] < R[C]; pc++; DISPATCH();
+		CASE(OP_ADDI, L_ADDI) BEGIN(); R[A] = R[B] + t->ins.imm; pc++; DISPATCH();
+		CASE(OP_ANDI, L_ANDI) BEGIN(); R[A] = R[B] & t->ins.imm; pc++; DISPATCH();
+		CASE(OP_ORI, L_ORI) BEGIN(); R[A] = R[B] | t->ins.imm; pc++; DISPATCH();
+		CASE(OP_SRL, L_SRL) BEGIN(); R[A] = R[B] >> t->ins.imm; pc++; DISPATCH();
+		CASE(OP_SLL, L_SLL) BEGIN(); R[A] = R[B] << t->ins.imm; pc++; DISPATCH();
+		CASE(OP_LW, L_LW)
+		{
+			uint32_t address = (uint32_t)R[B] + (uint32_t)t->ins.imm; //32 bit unsigned addresses, so memories above 2GB work
+			if (address % 4 != 0 || address >= addressLimit)
+				goto badAddress;
+			BEGIN(); R[A] = data.read(address / 4); pc++; DISPATCH();
+		}
+		CASE(OP_SW, L_SW)
+		{
+			uint32_t address = (uint32_t)R[B] + (uint32_t)t->ins.imm; //32 bit unsigned addresses, so memories above 2GB work
+			if (address % 4 != 0 || address >= addressLimit)
+				goto badAddress;
+			BEGIN(); data.write(address / 4, R[A]); pc++; DISPATCH();
+		}
+		CASE(OP_BEQ, L_BEQ) BEGIN(); pc = (R[A] == R[B]) ? t->ins.target : pc + 1; DISPATCH();
+		CASE(OP_BNE, L_BNE) BEGIN(); pc = (R[A] != R[B]) ? t->ins.target : pc + 1; DISPATCH();
+		CASE(OP_J, L_J) BEGIN(); pc = t->ins.target; DISPATCH();
+		CASE(OP_NOP, L_END) goto stop;
+#if !FUNCTIONAL_THREADED
+		}
+#endif
+
+	badAddress:
+		exitCode = MIPS_Architecture::INVALID_ADDRESS;
+		arch->PCcurr = pc; //so that handleExit shows the offending command
+	stop:
+#undef CASE
+#undef DISPATCH
+#undef BEGIN
+#undef A
+#undef B
+#undef C
+		arch->PCnext = pc;
+		instructionsExecuted = executed;
+		return exitCode;
+	}
+
+	//builds the threaded code once, one slot per instruction plus the end of program slot
+	void translate(const void *const *handlers)
+	{
+		code.assign(arch->program.size() + 1, ThreadedInstruction());
+		for (int i = 0; i <= (int)arch->program.size(); ++i)
+		{
+			code[i].ins = (i < (int)arch->program.size()) ? arch->program[i] : Instruction();
+			code[i].handler = handlers ? handlers[code[i].ins.op] : nullptr;
+		}
+	}
+
+	bool isDone()
+	{
+		return arch->PCnext >= (int)arch->program.size();
+	}
+};
+
+//runs the whole program on the functional model and prints the final state the same way the pipelines do,
+//with every instruction taking a single cycle
+void ExecuteFunctional(MIPS_Architecture *arch)
+{
+	if (arch->decodeError != arch->SUCCESS)
+	{
+		arch->handleExit(arch->decodeError, 0);
+		return;
+	} //a command could not be decoded
+	if ((long long)arch->commands.size() >= arch->addressLimit / 4)
+	{
+		arch->handleExit(arch->MEMORY_ERROR, 0);
+		return;
+	} //memory error
+	FunctionalModel model(arch);
+	int code = model.run();
+	arch->handleExit((MIPS_Architecture::exit_code)code, model.instructionsExecuted);
+}
+
+#endif
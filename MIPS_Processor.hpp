@@ -8,8 +8,12 @@
 #include <fstream>
 #include <exception>
 #include <iostream>
-#include <boost/tokenizer.hpp>
 #include <map>
+#include <cstdint>
+#include <PagedMemory.hpp>
+#include <Assembler.hpp>
+#include <Trace.hpp>
+#include <Cache.hpp>
 // #include<trial.cpp>
 
 using namespace std;
@@ -20,14 +24,29 @@ struct MIPS_Architecture
 	public:
 	int outputFormat = 0; //output format = 0 is the output format we used for debugging, it shows what each stage is doing at every cycle, and which PC is being executed
 	//in each stage. output format = 1 is the output format we used for the final submission, it shows the value of each register at every cycle.
+	//output format = 2 prints nothing at all, it is used when a pipeline is only run for its number of cycles (like in the sampled simulation)
+	Trace::Writer *trace = nullptr; //when set, the pipelines hand every cycle to it (a binary trace or the text of format 1)
+	MemoryHierarchy caches; //how long the fetches, loads and stores of the pipelines take, a cycle each unless enabled
+	int memoryStall = 0; //the cycles the accesses of the current cycle of a hand written pipeline still wait, see waitForMemory
 
 	int registers[32] = {0}, PCcurr = 0, PCnext = 0;
 	//std::unordered_map<std::string, std::function<int(MIPS_Architecture &, std::string, std::string, std::string)>> instructions;
-	std::unordered_map<std::string, int> registerMap, address;
+	std::unordered_map<std::string, int> registerMap;
 	static const int MAX = (1 << 20);
-	int data[MAX >> 2] = {0};
-	std::vector<std::vector<std::string>> commands;
+	long long addressLimit = MAX; //byte addresses from here on are invalid, MAX unless a larger memory was asked for (at most 4GB)
+	PagedMemory data; //word addressed, only the pages that were written to take up memory
+	std::vector<SourceCommand> commands; //the source text of each command, kept for printing
+	std::vector<int> commandLines; //the line of the source file each command is on
+	std::shared_ptr<SourceText> source; //the text the commands point into
+	SymbolTable labels; //each label and the index of the command it points to, -1 if it was defined more than once
+	std::vector<Instruction> program; //the decoded commands, this is what the pipelines execute
 	std::vector<int> commandCount;
+	//fetch bookkeeping for the sampled simulation. IF stops once fetched reaches fetchLimit (-1 means no limit), and
+	//timeFetches records the cycle of fetch number timedFrom (0 for none) and the cycle of the last allowed fetch, so
+	//the cycles in between are those of fetches timedFrom+1 to fetchLimit. The time parallel simulation also times the
+	//end of its intervals from the cycle of fetch number tailFrom
+	long long fetched = 0, fetchLimit = -1, timedFrom = 0, tailFrom = -1;
+	long long timedFromCycle = 0, fetchLimitCycle = -1, tailFromCycle = 0;
 	enum exit_code
 	{
 		SUCCESS = 0,
@@ -37,9 +56,32 @@ struct MIPS_Architecture
 		SYNTAX_ERROR,
 		MEMORY_ERROR
 	};
+	exit_code decodeError = SUCCESS; //set by constructCommands if some command could not be decoded, PCcurr then points to it
+	int errorCommand = 0;
 
 	// constructor to initialise the instruction set
-	MIPS_Architecture(std::ifstream &file)
+	MIPS_Architecture(std::ifstream &file, long long memoryBytes = MAX)
+	{
+		addressLimit = memoryBytes; //set first, the decoder checks constant addresses against it
+		initRegisterMap();
+		Assembler assembler(addressLimit);
+		assembler.assembleStream(file);
+		file.close();
+		constructCommands(assembler);
+	}
+
+	//maps the file instead of reading it, it can be source or an object written by the assembler.
+	//loaded is false (and there are no commands) if it could not be opened or is a damaged object
+	MIPS_Architecture(const std::string &fileName, bool &loaded, long long memoryBytes = MAX)
+	{
+		addressLimit = memoryBytes;
+		initRegisterMap();
+		Assembler assembler(addressLimit);
+		loaded = assembler.assembleFile(fileName);
+		constructCommands(assembler);
+	}
+
+	void initRegisterMap()
 	{
 		//instructions = {{"add", &MIPS_Architecture::add}, {"sub", &MIPS_Architecture::sub}, {"mul", &MIPS_Architecture::mul}, {"beq", &MIPS_Architecture::beq}, {"bne", &MIPS_Architecture::bne}, {"slt", &MIPS_Architecture::slt}, {"j", &MIPS_Architecture::j}, {"lw", &MIPS_Architecture::lw}, {"sw", &MIPS_Architecture::sw}, {"addi", &MIPS_Architecture::addi}};
 		for (int i = 0; i < 32; ++i)
@@ -60,9 +102,6 @@ struct MIPS_Architecture
 		registerMap["$sp"] = 29;
 		registerMap["$s8"] = 30;
 		registerMap["$ra"] = 31;
-
-		constructCommands(file);
-		commandCount.assign(commands.size(), 0);
 	}
 
 	// perform the beq operation
@@ -84,11 +123,11 @@ struct MIPS_Architecture
 	{
 		if (!checkLabel(label))
 			return 4;
-		if (address.find(label) == address.end() || address[label] == -1)
+		if (labelIndex(label) == -1)
 			return 2;
 		if (!checkRegisters({r1, r2}))
 			return 1;
-		PCnext = comp(registers[registerMap[r1]], registers[registerMap[r2]]) ? address[label] : PCcurr + 1;
+		PCnext = comp(registers[registerMap[r1]], registers[registerMap[r2]]) ? labelIndex(label) : PCcurr + 1;
 		return 0;
 	}
 
@@ -103,38 +142,38 @@ struct MIPS_Architecture
 	}
 
 	// perform the jump operation
-	int j(std::string label, std::string unused1 = "", std::string unused2 = "")
+	int j(std::string label, std::string = "", std::string = "")
 	{
 		if (!checkLabel(label))
 			return 4;
-		if (address.find(label) == address.end() || address[label] == -1)
+		if (labelIndex(label) == -1)
 			return 2;
-		PCnext = address[label];
+		PCnext = labelIndex(label);
 		return 0;
 	}
 
 	// perform load word operation
-	int lw(std::string r, std::string location, std::string unused1 = "")
+	int lw(std::string r, std::string location, std::string = "")
 	{
 		if (!checkRegister(r) || registerMap[r] == 0)
 			return 1;
 		int address = locateAddress(location);
 		if (address < 0)
 			return abs(address);
-		registers[registerMap[r]] = data[address];
+		registers[registerMap[r]] = data.read(address);
 		PCnext = PCcurr + 1;
 		return 0;
 	}
 	//hello
 	// perform store word operation
-	int sw(std::string r, std::string location, std::string unused1 = "")
+	int sw(std::string r, std::string location, std::string = "")
 	{
 		if (!checkRegister(r))
 			return 1;
 		int address = locateAddress(location);
 		if (address < 0)
 			return abs(address);
-		data[address] = registers[registerMap[r]];
+		data.write(address, registers[registerMap[r]]);
 		PCnext = PCcurr + 1;
 		return 0;
 	}
@@ -158,7 +197,7 @@ struct MIPS_Architecture
 		try
 		{
 			int address = stoi(addr);
-			if (address % 4 || address >= MAX)
+			if (address % 4 || address >= addressLimit)
 				return {-3,"$0"};
 			return {address/4, "$0"};
 		}
@@ -183,7 +222,7 @@ struct MIPS_Architecture
 				}
 					
 				int address = registers[registerMap[reg]] + offset;
-				if (address % 4 != 0 || address < (4 * commands.size()) || address >= MAX)
+				if (address % 4 != 0 || address < int(4 * commands.size()) || address >= addressLimit)
 				{	
 					return -3;
 				}
@@ -198,7 +237,7 @@ struct MIPS_Architecture
 		try
 		{
 			int address = stoi(location);
-			if (address % 4 || address < int(4 * commands.size()) || address >= MAX)
+			if (address % 4 || address < int(4 * commands.size()) || address >= addressLimit)
 				return -3;
 			return address / 4;
 		}
@@ -256,8 +295,10 @@ struct MIPS_Architecture
 		4: syntax error
 		5: commands exceed memory limit
 	*/
-	void handleExit(exit_code code, int cycleCount)
+	void handleExit(exit_code code, long long cycleCount)
 	{
+		if (trace)
+			trace->finish(); //the writer thread may still be writing cycles
 		std::cout << '\n';
 		switch (code)
 		{
@@ -281,18 +322,25 @@ struct MIPS_Architecture
 		}
 		if (code != 0)
 		{
-			std::cerr << "Error encountered at:\n";
+			std::cerr << "Error encountered at line " << commandLines[PCcurr] << ":\n";
 			for (auto &s : commands[PCcurr])
 				std::cerr << s << ' ';
 			std::cerr << '\n';
 		}
-		if(outputFormat == 0)
+		if(outputFormat == 0 || (trace && !trace->text)) //the cycles went to a binary trace, the summary is still printed
 		{
 			std::cout << "\nFollowing are the non-zero data values:\n";
-			for (int i = 0; i < MAX / 4; ++i)
-				if (data[i] != 0)
-					std::cout << 4 * i << '-' << 4 * i + 3 << ": " << data[i] << '\n'
-							<< std::dec;
+			for (uint32_t number : data.sortedPages()) //only the pages that were written can hold non-zero values
+			{
+				const int *page = data.page(number);
+				for (uint32_t i = 0; i < PagedMemory::PAGE_WORDS; ++i)
+					if (page[i] != 0)
+					{
+						long long address = 4LL * ((number << PagedMemory::PAGE_BITS) + i);
+						std::cout << address << '-' << address + 3 << ": " << page[i] << '\n'
+								<< std::dec;
+					}
+			}
 					
 			std::cout << "\nTotal number of cycles: " << cycleCount << '\n';
 			std::cout << "Count of instructions executed:\n";
@@ -304,6 +352,8 @@ struct MIPS_Architecture
 				std::cout << '\n';
 			}
 		}
+		if (caches.enabled)
+			caches.report(std::cout);
 	}
 	int instructionNumber(string s)
 	{
@@ -315,81 +365,105 @@ struct MIPS_Architecture
 			return 2;
 		return 3; //branch/jump type instructions
 	}
-	// parse the command assuming correctly formatted MIPS instruction (or label)
-	void parseCommand(std::string line)
+
+	// the index of the command a label points to, -1 if it is not defined or defined more than once
+	int labelIndex(const std::string &label) const
 	{
-		// strip until before the comment begins
-		line = line.substr(0, line.find('#'));
-		std::vector<std::string> command;
-		boost::tokenizer<boost::char_separator<char>> tokens(line, boost::char_separator<char>(", \t"));
-		for (auto &s : tokens)
-			command.push_back(s);
-		// empty line or a comment only line
-		if (command.empty())
-			return;
-		else if (command.size() == 1)
-		{
-			std::string label = command[0].back() == ':' ? command[0].substr(0, command[0].size() - 1) : "?";
-			if (address.find(label) == address.end())
-				address[label] = commands.size();
-			else
-				address[label] = -1;
-			command.clear();
-		}
-		else if (command[0].back() == ':')
-		{
-			std::string label = command[0].substr(0, command[0].size() - 1);
-			if (address.find(label) == address.end())
-				address[label] = commands.size();
-			else
-				address[label] = -1;
-			command = std::vector<std::string>(command.begin() + 1, command.end());
-		}
-		else if (command[0].find(':') != std::string::npos)
-		{
-			int idx = command[0].find(':');
-			std::string label = command[0].substr(0, idx);
-			if (address.find(label) == address.end())
-				address[label] = commands.size();
-			else
-				address[label] = -1;
-			command[0] = command[0].substr(idx + 1);
-		}
-		else if (command[1][0] == ':')
+		int id = labels.find(label);
+		return id < 0 ? -1 : labels.values[id];
+	}
+
+	// takes over what the assembler produced, the first command that could not be decoded ends up in decodeError and PCcurr
+	void constructCommands(Assembler &assembler)
+	{
+		source = assembler.source;
+		commands = std::move(assembler.commands);
+		commandLines = std::move(assembler.lines);
+		program = std::move(assembler.program);
+		labels = std::move(assembler.labels);
+		decodeError = (exit_code)assembler.error;
+		errorCommand = assembler.errorCommand;
+		if (decodeError != SUCCESS)
+			PCcurr = errorCommand;
+		commandCount.assign(commands.size(), 0);
+	}
+
+	//starts over on the program of from (which may be this one) with zeroed registers and memory and no fetch limit.
+	//The pages of data stay allocated and the vectors keep their capacity, so a thread can run many short programs one
+	//after another on the same architecture without allocating it again for each of them. outputFormat, trace and the
+	//configuration of the caches stay, the caches themselves are emptied
+	void reset(const MIPS_Architecture &from)
+	{
+		if (&from != this)
 		{
-			if (address.find(command[0]) == address.end())
-				address[command[0]] = commands.size();
-			else
-				address[command[0]] = -1;
-			command[1] = command[1].substr(1);
-			if (command[1] == "")
-				command.erase(command.begin(), command.begin() + 2);
-			else
-				command.erase(command.begin(), command.begin() + 1);
+			addressLimit = from.addressLimit;
+			commands = from.commands;
+			commandLines = from.commandLines;
+			source = from.source;
+			labels = from.labels;
+			program = from.program;
+			decodeError = from.decodeError;
+			errorCommand = from.errorCommand;
 		}
-		if (command.empty())
-			return;
-		if (command.size() > 4)
-			for (int i = 4; i < (int)command.size(); ++i)
-				command[3] += " " + command[i];
-		command.resize(4);
-		commands.push_back(command);
+		std::fill(registers, registers + 32, 0);
+		PCcurr = (decodeError != SUCCESS) ? errorCommand : 0;
+		PCnext = 0;
+		data.zero();
+		commandCount.assign(commands.size(), 0);
+		fetched = 0, fetchLimit = -1, timedFrom = 0, tailFrom = -1;
+		timedFromCycle = 0, fetchLimitCycle = -1, tailFromCycle = 0;
+		caches.clear();
+		memoryStall = 0;
 	}
 
+	//the execution of commands is left to the pipeline that is using this architecture
 
-	// construct the commands vector from the input file
-	void constructCommands(std::ifstream &file)
+	//true once IF should stop fetching, either the program is over or the fetch limit was reached
+	bool fetchDone()
 	{
-		std::string line;
-		while (getline(file, line))
-			parseCommand(line);
-		file.close();
+		return PCnext >= (int)program.size() || fetched == fetchLimit;
 	}
 
-	
+	//called by IF for every command it fetches, PCcurr is the fetched command
+	void countFetch()
+	{
+		++commandCount[PCcurr];
+		++fetched;
+	}
 
+	//called by the pipelines at the end of every cycle
+	void timeFetches(long long clockCycle)
+	{
+		if (fetched < timedFrom)
+			timedFromCycle = clockCycle + 1;
+		if (fetched < tailFrom)
+			tailFromCycle = clockCycle + 1;
+		if (fetched < fetchLimit)
+			fetchLimitCycle = clockCycle + 1;
+	}
 
-	//the execution of commands is left to the pipeline that is using this architecture
+	//the hand written pipelines stop altogether while a cache miss is served. Called at the end of every cycle, it counts
+	//and reports the cycles spent waiting for the accesses of that cycle and returns how many there were
+	int waitForMemory(int clockCycle)
+	{
+		int stall = memoryStall;
+		memoryStall = 0;
+		for (int i = 1; i <= stall && (outputFormat != 2 || trace); ++i)
+		{
+			if (outputFormat != 2)
+			{
+				if (outputFormat == 0)
+					std::cout << "waiting for memory ";
+				printRegisters(clockCycle + i);
+				std::cout << 0 << std::endl;
+			}
+			if (trace)
+				trace->cycle(registers, false, 0, 0);
+		}
+		if (stall > 0)
+			timeFetches(clockCycle + stall); //nothing is fetched meanwhile, so only the last of them counts
+		return stall;
+	}
 
 	// print the register data in hexadecimal
 	void printRegisters(int clockCycle)
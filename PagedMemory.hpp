@@ -0,0 +1,285 @@
+#ifndef __PAGED_MEMORY_HPP__
+#define __PAGED_MEMORY_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <iostream>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define PAGED_MEMORY_MMAP 1
+#else
+#define PAGED_MEMORY_MMAP 0
+#endif
+
+//sparse word addressed data memory. The 2^30 words of a 32 bit address space are split into 4KB pages held in a two level
+//table, and a page is only allocated the first time something non-zero is written into it. Untouched parts of the tables
+//point at shared pages of zeroes, so a read never allocates and never has to check whether its page exists.
+//By default pages come from new, reserve() makes them come from one big mmap'ed region instead (optionally backed by huge
+//pages), and mapImage() points the table straight at the pages of a file so large inputs are never copied in.
+struct PagedMemory
+{
+	static const int PAGE_BITS = 10, DIRECTORY_BITS = 10; //1024 words per page, 1024 pages per directory
+	static const uint32_t PAGE_WORDS = 1u << PAGE_BITS, DIRECTORY_PAGES = 1u << DIRECTORY_BITS;
+	static const uint32_t DIRECTORIES = 1u << (30 - PAGE_BITS - DIRECTORY_BITS);
+	static const uint32_t WORD_MASK = (1u << 30) - 1;
+	static const uint64_t PAGE_BYTES = 4 * PAGE_WORDS;
+
+	int **directories[DIRECTORIES];
+	std::vector<uint32_t> dirtyPages; //numbers of the pages allocated or mapped so far, in the order they were first written
+	char *arena = nullptr; //after reserve(), the pages of the first arenaBytes bytes live here at their own offset
+	uint64_t arenaBytes = 0;
+	std::vector<std::pair<char *, uint64_t>> images; //the mapped image files and their sizes
+
+	PagedMemory()
+	{
+		std::fill(directories, directories + DIRECTORIES, zeroDirectory());
+	}
+	PagedMemory(const PagedMemory &other) : PagedMemory()
+	{
+		*this = other;
+	}
+	PagedMemory &operator=(const PagedMemory &other)
+	{
+		if (this == &other)
+			return *this;
+		clear();
+		for (uint32_t number : other.dirtyPages)
+			std::copy(other.page(number), other.page(number) + PAGE_WORDS, allocate(number << PAGE_BITS));
+		return *this;
+	}
+	~PagedMemory()
+	{
+		release(false);
+#if PAGED_MEMORY_MMAP
+		if (arena)
+			munmap(arena, arenaBytes);
+#endif
+	}
+
+	int read(uint32_t word) const
+	{
+		word &= WORD_MASK;
+		return directories[word >> (PAGE_BITS + DIRECTORY_BITS)][(word >> PAGE_BITS) & (DIRECTORY_PAGES - 1)][word & (PAGE_WORDS - 1)];
+	}
+	void write(uint32_t word, int value)
+	{
+		word &= WORD_MASK;
+		int *p = directories[word >> (PAGE_BITS + DIRECTORY_BITS)][(word >> PAGE_BITS) & (DIRECTORY_PAGES - 1)];
+		if (p == zeroPage())
+		{
+			if (value == 0)
+				return; //already zero, no need for a page
+			p = allocate(word);
+		}
+		p[word & (PAGE_WORDS - 1)] = value;
+	}
+
+	//the words of page number, PAGE_WORDS of them
+	const int *page(uint32_t number) const
+	{
+		return directories[number >> DIRECTORY_BITS][number & (DIRECTORY_PAGES - 1)];
+	}
+	//the allocated page numbers in increasing order, which is the order of their addresses
+	std::vector<uint32_t> sortedPages() const
+	{
+		std::vector<uint32_t> pages = dirtyPages;
+		std::sort(pages.begin(), pages.end());
+		return pages;
+	}
+
+	//back to all zeroes, frees every page and unmaps the images (the reserved region stays reserved)
+	void clear()
+	{
+		release(true);
+	}
+
+	//back to all zeroes like clear(), but the pages stay allocated for whatever is written next (the images are still
+	//unmapped). Cheaper than clear() when a short program is about to run on the same memory again
+	void zero()
+	{
+		if (!images.empty())
+		{
+			clear();
+			return;
+		}
+		for (uint32_t number : dirtyPages)
+			memset(entry(number), 0, PAGE_BYTES);
+	}
+
+	//reserves bytes of address space in one mapping that later pages are taken from. With hugePages it first tries
+	//hugetlbfs pages (which must have been set aside in /proc/sys/vm/nr_hugepages) and then transparent huge pages.
+	//returns false if nothing could be mapped, the memory then simply keeps allocating pages with new
+	bool reserve(uint64_t bytes, bool hugePages)
+	{
+#if PAGED_MEMORY_MMAP
+		if (arena)
+			return false; //pages may already point into the current one
+		const uint64_t hugePage = 2 << 20;
+		void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+		if (hugePages)
+		{
+			p = mmap(nullptr, (bytes + hugePage - 1) / hugePage * hugePage, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (p != MAP_FAILED)
+				bytes = (bytes + hugePage - 1) / hugePage * hugePage;
+		}
+#endif
+		if (p == MAP_FAILED)
+		{
+			bytes = (bytes + PAGE_BYTES - 1) / PAGE_BYTES * PAGE_BYTES;
+			p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+#ifdef MADV_HUGEPAGE
+			if (p != MAP_FAILED && hugePages)
+				madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+		}
+		if (p == MAP_FAILED)
+			return false;
+		arena = (char *)p;
+		arenaBytes = bytes;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	//maps the file at byte address (a multiple of PAGE_BYTES) without reading it. The mapping is private, so stores
+	//into it never reach the file. The pages it covers must not have been written yet and it has to end below limit.
+	//returns false (with a message on cerr) if the image can not be mapped
+	bool mapImage(const std::string &fileName, uint64_t address, uint64_t limit = 4 * ((uint64_t)WORD_MASK + 1))
+	{
+#if PAGED_MEMORY_MMAP
+		if (address % PAGE_BYTES != 0)
+		{
+			std::cerr << "Image " << fileName << " must be mapped at a multiple of " << PAGE_BYTES << '\n';
+			return false;
+		}
+		int fd = open(fileName.c_str(), O_RDONLY);
+		struct stat status;
+		if (fd < 0 || fstat(fd, &status) != 0)
+		{
+			std::cerr << "Could not open image " << fileName << '\n';
+			if (fd >= 0)
+				close(fd);
+			return false;
+		}
+		uint64_t bytes = (status.st_size + PAGE_BYTES - 1) / PAGE_BYTES * PAGE_BYTES;
+		uint32_t first = address / PAGE_BYTES, count = bytes / PAGE_BYTES;
+		bool ok = (address + status.st_size <= limit);
+		for (uint32_t i = 0; ok && i < count; ++i)
+			ok = (page(first + i) == zeroPage());
+		if (!ok)
+		{
+			std::cerr << "Image " << fileName << " does not fit at " << address << " or overlaps memory already in use\n";
+			close(fd);
+			return false;
+		}
+		void *p = (bytes == 0) ? nullptr : mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (p == MAP_FAILED)
+		{
+			std::cerr << "Could not map image " << fileName << '\n';
+			return false;
+		}
+		if (bytes == 0)
+			return true;
+		images.push_back({(char *)p, bytes});
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			entry(first + i) = (int *)((char *)p + i * PAGE_BYTES);
+			dirtyPages.push_back(first + i);
+		}
+		return true;
+#else
+		std::cerr << "Mapping images is not supported on this platform\n";
+		return false;
+#endif
+	}
+
+	private:
+	//frees the pages and tables and unmaps the images, arena pages are only zeroed when the arena is going to be reused
+	void release(bool zeroArena)
+	{
+		for (uint32_t d = 0; d < DIRECTORIES; ++d)
+		{
+			if (directories[d] == zeroDirectory())
+				continue;
+			for (uint32_t p = 0; p < DIRECTORY_PAGES; ++p)
+			{
+				int *page = directories[d][p];
+				if (page == zeroPage() || inImage(page))
+					continue;
+				if (!inArena(page))
+					delete[] page;
+				else if (zeroArena)
+					memset(page, 0, PAGE_BYTES);
+			}
+			delete[] directories[d];
+			directories[d] = zeroDirectory();
+		}
+		dirtyPages.clear();
+#if PAGED_MEMORY_MMAP
+		for (auto &image : images)
+			munmap(image.first, image.second);
+#endif
+		images.clear();
+	}
+
+	//the table entry of page number, allocating its directory if needed
+	int *&entry(uint32_t number)
+	{
+		int **&directory = directories[number >> DIRECTORY_BITS];
+		if (directory == zeroDirectory())
+		{
+			directory = new int *[DIRECTORY_PAGES];
+			std::fill(directory, directory + DIRECTORY_PAGES, zeroPage());
+		}
+		return directory[number & (DIRECTORY_PAGES - 1)];
+	}
+
+	//allocates the (zeroed) page holding word, which must not have one yet
+	int *allocate(uint32_t word)
+	{
+		uint32_t number = word >> PAGE_BITS;
+		int *&p = entry(number);
+		if ((uint64_t)number * PAGE_BYTES < arenaBytes)
+			p = (int *)(arena + (uint64_t)number * PAGE_BYTES); //anonymous mappings start out zeroed
+		else
+			p = new int[PAGE_WORDS]();
+		dirtyPages.push_back(number);
+		return p;
+	}
+
+	bool inArena(const int *p) const
+	{
+		return arena && (const char *)p >= arena && (const char *)p < arena + arenaBytes;
+	}
+	bool inImage(const int *p) const
+	{
+		for (auto &image : images)
+			if ((const char *)p >= image.first && (const char *)p < image.first + image.second)
+				return true;
+		return false;
+	}
+
+	static int *zeroPage()
+	{
+		static int page[PAGE_WORDS] = {0};
+		return page;
+	}
+	static int **zeroDirectory()
+	{
+		static int *directory[DIRECTORY_PAGES];
+		static bool filled = (std::fill(directory, directory + DIRECTORY_PAGES, zeroPage()), true);
+		(void)filled;
+		return directory;
+	}
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef __PIPELINE_HPP__
+#define __PIPELINE_HPP__
+
+#include <tuple>
+#include <type_traits>
+#include <MIPS_Processor.hpp>
+
+//the engine the pipeline models are built on. A model is a configuration of it: the state its stages share, the list of its
+//latches and, in the order they run within a cycle, its stages together with the latches each one is connected to.
+//cycle() then runs every stage and moves every latch on. Everything is held by value and known at compile time, so a cycle is a sequence of direct
+//calls the compiler can inline, the way the hand written loops were.
+
+//a latch between two stages. During a cycle the stage before it writes next and the stage after it reads cur, update()
+//then copies next into cur. T has to be trivially copyable, so that copy is a fixed size memcpy with no allocation, and
+//its clear() resets whatever should not be carried into the next cycle (usually to a bubble), everything else keeps its
+//value until it is written again
+template <typename T>
+struct Latch
+{
+	static_assert(std::is_trivially_copyable<T>::value, "latch payloads must be trivially copyable");
+	T cur, next;
+
+	void update()
+	{
+		cur = next;
+		next.clear();
+	}
+};
+
+//the latches of a pipeline, they are updated in this order
+template <typename... L>
+struct Latches {};
+
+//stage S connected to the latches at the given positions of the Latches list, S is constructed from arch, a pointer to
+//the shared state of the pipeline if it takes one, and then pointers to those latches
+template <typename S, int... Connected>
+struct Connect
+{
+	using type = S;
+	template <typename State, typename Tuple>
+	static S make(MIPS_Architecture *arch, State &state, Tuple &latches)
+	{
+		if constexpr (std::is_constructible<S, MIPS_Architecture *, State *, decltype(&std::get<Connected>(latches))...>::value)
+			return S(arch, &state, &std::get<Connected>(latches)...);
+		else
+			return S(arch, &std::get<Connected>(latches)...);
+	}
+};
+
+template <typename State, typename LatchList, typename... Stages>
+struct Pipeline;
+
+//State is whatever the stages share besides the latches (a hazard scoreboard for instance), it belongs to the pipeline
+//so that any number of them can run side by side
+template <typename State, typename... L, typename... Stages>
+struct Pipeline<State, Latches<L...>, Stages...>
+{
+	MIPS_Architecture *arch;
+	State state;
+	std::tuple<L...> latches;
+	std::tuple<typename Stages::type...> stages; //in the order they run
+
+	Pipeline(MIPS_Architecture *architecture) : arch(architecture), stages(Stages::make(arch, state, latches)...) {}
+	//the stages point into state and latches
+	Pipeline(const Pipeline &) = delete;
+	Pipeline &operator=(const Pipeline &) = delete;
+
+	//back to the empty pipeline the constructor made, without allocating a new one
+	void reset()
+	{
+		state = State();
+		latches = std::tuple<L...>();
+		stages = std::tuple<typename Stages::type...>(Stages::make(arch, state, latches)...);
+	}
+
+	//the stage at position i of the list
+	template <int i>
+	auto &stage()
+	{
+		return std::get<i>(stages);
+	}
+
+	void cycle()
+	{
+		std::apply([](auto &...s) { (s.run(), ...); }, stages);
+		std::apply([](auto &...l) { (l.update(), ...); }, latches);
+	}
+};
+
+#endif
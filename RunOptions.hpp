@@ -0,0 +1,149 @@
+#ifndef __RUN_OPTIONS_HPP__
+#define __RUN_OPTIONS_HPP__
+
+#include <MIPS_Processor.hpp>
+#include <Checkpoint.hpp>
+
+//the command line shared by all the binaries, <file name> (source or an object written by assembleFinal) followed by any of
+//	--resume <checkpoint>		start from a checkpoint instead of the first command
+//	--memory <bytes>			size of the simulated address space, 1MB by default and at most 4G. Anything above 1MB is
+//								reserved with a single mmap, and k/m/g suffixes are allowed
+//	--hugepages					back the memory with huge pages (hugetlbfs if some were set aside, transparent ones otherwise)
+//	--map <image> <address>		map a binary file of little endian words at a byte address (a multiple of 4096) without
+//								copying it in, can be given several times
+//	--format <0|1|2>			the output format of the pipelines, see MIPS_Architecture::outputFormat
+//	--trace <file>				the pipelines write a binary trace of every cycle (see Trace.hpp) instead of printing it,
+//								traceFinal turns it back into the text of --format 1
+//	--caches <config>			time the fetches, loads and stores with the L1 caches and memory described in config (see
+//								caches.cfg and Cache.hpp), without it every access takes a cycle
+//whatever else is on the command line is left in rest for the binary itself.
+struct RunOptions
+{
+	static constexpr const char *usage = "[--resume <checkpoint>] [--memory <bytes>] [--hugepages] [--map <image> <address>]... [--format <0|1|2>] [--trace <file>] [--caches <config>]";
+
+	std::string fileName, resume, trace, caches;
+	int outputFormat = 0;
+	long long memory = MIPS_Architecture::MAX;
+	bool hugePages = false;
+	std::vector<std::pair<std::string, long long>> images;
+	std::vector<std::string> rest;
+
+	//a byte count like 4096, 0x1000, 64m or 4g, -1 if it is not one
+	static long long parseBytes(std::string s)
+	{
+		try
+		{
+			size_t used = 0;
+			long long value = stoll(s, &used, 0);
+			std::string suffix = s.substr(used);
+			if (suffix == "k" || suffix == "K")
+				value <<= 10;
+			else if (suffix == "m" || suffix == "M")
+				value <<= 20;
+			else if (suffix == "g" || suffix == "G")
+				value <<= 30;
+			else if (suffix != "")
+				return -1;
+			return value;
+		}
+		catch (std::exception &e)
+		{
+			return -1;
+		}
+	}
+
+	//argv[1] is the file name, returns false if the options are malformed
+	bool parse(int argc, char *argv[])
+	{
+		if (argc < 2)
+			return false;
+		fileName = argv[1];
+		for (int i = 2; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			if (arg == "--resume" && i + 1 < argc)
+				resume = argv[++i];
+			else if (arg == "--memory" && i + 1 < argc)
+			{
+				memory = parseBytes(argv[++i]);
+				if (memory < 4 || memory > (4LL << 30))
+					return false;
+			}
+			else if (arg == "--hugepages")
+				hugePages = true;
+			else if (arg == "--format" && i + 1 < argc)
+			{
+				arg = argv[++i];
+				if (arg != "0" && arg != "1" && arg != "2")
+					return false;
+				outputFormat = stoi(arg);
+			}
+			else if (arg == "--trace" && i + 1 < argc)
+				trace = argv[++i];
+			else if (arg == "--caches" && i + 1 < argc)
+				caches = argv[++i];
+			else if (arg == "--map" && i + 2 < argc)
+			{
+				images.push_back({argv[i + 1], parseBytes(argv[i + 2])});
+				if (images.back().second < 0)
+					return false;
+				i += 2;
+			}
+			else
+				rest.push_back(arg);
+		}
+		return true;
+	}
+
+	//reads the program and sets up its memory and starting state, returns nullptr (after saying why) if that fails
+	MIPS_Architecture *load()
+	{
+		bool loaded;
+		MIPS_Architecture *mips = new MIPS_Architecture(fileName, loaded, memory);
+		if (!loaded)
+		{
+			std::cerr << "File could not be opened. Terminating...\n";
+			delete mips;
+			return nullptr;
+		}
+		if ((memory > MIPS_Architecture::MAX || hugePages) && !mips->data.reserve(memory, hugePages))
+			std::cerr << "Could not reserve " << memory << " bytes with mmap, allocating pages on demand instead\n";
+		for (auto &image : images)
+			if (!mips->data.mapImage(image.first, image.second, memory))
+			{
+				delete mips;
+				return nullptr;
+			}
+		if (caches != "" && !mips->caches.load(caches))
+		{
+			delete mips;
+			return nullptr;
+		}
+		if (resume != "" && !Checkpoint::load(mips, resume))
+		{
+			delete mips;
+			return nullptr;
+		}
+		mips->outputFormat = outputFormat;
+		if (trace != "")
+		{
+			mips->trace = new Trace::Writer();
+			if (!mips->trace->open(trace))
+			{
+				delete mips->trace;
+				delete mips;
+				return nullptr;
+			}
+			mips->outputFormat = 2;
+		}
+		else if (outputFormat == 1)
+		{
+			mips->trace = new Trace::Writer(); //the lines are formatted and written on another thread
+			mips->trace->openText(std::cout);
+			mips->outputFormat = 2;
+		}
+		return mips;
+	}
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef __SAMPLING_HPP__
+#define __SAMPLING_HPP__
+
+#include <MIPS_Processor.hpp>
+#include <FunctionalModel.hpp>
+#include <cmath>
+
+//sampled simulation in the style of SMARTS. Every period instructions a detailed window is run on one of the pipelines,
+//warmup instructions to fill it and then window instructions that are timed, and the functional model fast forwards
+//through the rest of the period. The mean CPI of the timed windows estimates the CPI of the whole program.
+struct SamplingResult
+{
+	int exitCode = 0;
+	long long instructions = 0; //everything executed, fast forwarded or detailed
+	long long samples = 0;
+	double cpi = 0, cpiError = 0; //mean CPI of the samples and the half width of its confidence interval
+	double variation = 0; //coefficient of variation of the sampled CPIs
+	double z = 3;
+
+	long long cycles()
+	{
+		return llround(cpi * instructions);
+	}
+	double cyclesError()
+	{
+		return cpiError * instructions;
+	}
+	//number of samples that would give a confidence interval of +-epsilon (relative) at the same confidence
+	long long samplesNeeded(double epsilon)
+	{
+		return (long long)ceil(pow(z * variation / epsilon, 2));
+	}
+};
+
+//runPipeline is the RunPipeline of the timing model, period warmup and window are counted in instructions and
+//z is the normal quantile of the confidence level (3 for 99.7%)
+SamplingResult RunSampled(MIPS_Architecture *arch, int (*runPipeline)(MIPS_Architecture *), long long period,
+	long long warmup, long long window, double z = 3)
+{
+	SamplingResult result;
+	result.z = z;
+	FunctionalModel model(arch);
+	int outputFormat = arch->outputFormat;
+	arch->outputFormat = 2; //the windows are only run for their cycle counts
+	long long detailed = 0;
+	double sum = 0, sumSquares = 0;
+	while (!model.isDone())
+	{
+		arch->fetched = 0;
+		arch->fetchLimit = warmup + window;
+		arch->timedFrom = warmup;
+		arch->timedFromCycle = 0;
+		arch->fetchLimitCycle = -1;
+		runPipeline(arch);
+		detailed += arch->fetched;
+		if (arch->fetched == arch->fetchLimit) //a window cut short by the end of the program is not a sample
+		{
+			double cpi = double(arch->fetchLimitCycle - arch->timedFromCycle) / window;
+			sum += cpi;
+			sumSquares += cpi * cpi;
+			++result.samples;
+		}
+
+		result.exitCode = model.run(period - warmup - window);
+		if (result.exitCode != MIPS_Architecture::SUCCESS)
+			break;
+	}
+	arch->fetchLimit = -1;
+	arch->outputFormat = outputFormat;
+
+	result.instructions = model.instructionsExecuted + detailed;
+	long long n = result.samples;
+	if (n > 0)
+		result.cpi = sum / n;
+	if (n > 1)
+	{
+		double deviation = sqrt(max(0.0, (sumSquares - n * result.cpi * result.cpi) / (n - 1)));
+		result.cpiError = z * deviation / sqrt((double)n);
+		result.variation = deviation / result.cpi;
+	}
+	return result;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __SCOREBOARD_HPP__
+#define __SCOREBOARD_HPP__
+
+#include <cstdint>
+
+//the registers that instructions in flight are going to write, used by the pipelines to find data hazards.
+//a register is pending while its bit is set, position[] is the latch its writer has reached and kind[] whatever else the
+//pipeline needs to know about that writer (whether it is a load for instance). Both are only meaningful while pending.
+struct Scoreboard
+{
+	uint32_t pending = 0;
+	int position[32] = {0};
+	int kind[32] = {0};
+
+	bool has(int reg) const
+	{
+		return reg >= 0 && (pending >> reg & 1);
+	}
+	void set(int reg, int newPosition, int newKind = 0)
+	{
+		pending |= 1u << reg;
+		position[reg] = newPosition;
+		kind[reg] = newKind;
+	}
+	//called once a cycle, every writer moves one latch further and the ones reaching maxPosition are done
+	void age(int maxPosition)
+	{
+		for (uint32_t m = pending; m; m &= m - 1)
+		{
+			int reg = __builtin_ctz(m);
+			if (++position[reg] >= maxPosition)
+				pending &= ~(1u << reg);
+		}
+	}
+	void clear()
+	{
+		pending = 0;
+	}
+};
+
+#endif
@@ -0,0 +1,329 @@
+#ifndef __SWEEP_HPP__
+#define __SWEEP_HPP__
+
+#include <MIPS_Processor.hpp>
+#include <FunctionalModel.hpp>
+#include <BranchPredictor.hpp>
+#include <ThreadPool.hpp>
+#include <5stage.hpp>
+#include <5stage_bypass.hpp>
+#include <79stage.hpp>
+#include <parametric.hpp>
+#include <iomanip>
+
+//a design space sweep: every program against every point of a grid of pipelines and branch predictors, all run in one
+//process on a ThreadPool and written out as one table.
+//The hand written pipelines stall fetch on every branch, so their cycles do not depend on the predictor point: they are
+//run once and a predictor point is scored on the branches of the program as the functional model executes them, both
+//kinds of run being jobs of their own that the table pairs up. A config of the parametric model is run once for every
+//predictor point instead, with that predictor in place of its own, and its row has the cycles and the branches of that
+//run (without predictor points it keeps the predictor of its config).
+//Every program is parsed once up front and a worker keeps one MIPS_Architecture that it resets to the program of each
+//job it runs (see MIPS_Architecture::reset), so a large grid does not read and parse the same file for every point.
+namespace Sweep
+{
+
+//5stage, 79stage or a config file of the parametric model, with forwarding on or off
+struct PipelinePoint
+{
+	string model;
+	bool forwarding = false;
+	bool parametric = false;
+	ParametricStage::Config config;
+	int (*runPipeline)(MIPS_Architecture *) = nullptr;
+};
+
+struct PredictorPoint
+{
+	string type; //a name makeBranchPredictor knows
+	int counter = 0; //the state every counter starts in
+	int tableBits = 14; //the tables have 2^tableBits counters
+	int historyBits = 12; //the branches gshare, tournament, hybrid and perceptron remember
+
+	bool hasCounters() const
+	{
+		return type != "not_taken" && type != "perceptron";
+	}
+	bool hasTable() const
+	{
+		return type != "bhr" && type != "not_taken";
+	}
+	bool hasHistory() const
+	{
+		return type == "gshare" || type == "tournament" || type == "hybrid" || type == "perceptron";
+	}
+	int maxHistoryBits() const
+	{
+		return type == "perceptron" ? 1024 : 24;
+	}
+	//false for a perceptron too large to allocate, see PerceptronBranchPredictor::fits
+	bool fits() const
+	{
+		return type != "perceptron" || PerceptronBranchPredictor::fits(tableBits, historyBits);
+	}
+};
+
+struct TimingResult
+{
+	int exitCode = MIPS_Architecture::SUCCESS;
+	long long instructions = 0, cycles = 0;
+	long long branches = -1, mispredictions = 0; //as the parametric model predicted them, -1 for the other pipelines
+};
+
+struct PredictorResult
+{
+	int exitCode = MIPS_Architecture::SUCCESS;
+	long long branches = 0, mispredictions = 0;
+};
+
+//the pipeline a model name and forwarding setting stand for, false if there is none (79stage has no forwarding)
+bool makePipeline(const string &model, bool forwarding, PipelinePoint &point)
+{
+	point.model = model;
+	point.forwarding = forwarding;
+	if (model == "5stage")
+	{
+		point.runPipeline = forwarding ? FiveStageBypass::RunPipeline : FiveStage::RunPipeline;
+		return true;
+	}
+	if (model == "79stage")
+	{
+		point.runPipeline = SevenNineStage::RunPipeline;
+		return !forwarding;
+	}
+	point.parametric = true;
+	if (!point.config.load(model))
+		return false;
+	point.config.forwarding = forwarding;
+	return true;
+}
+
+BranchPredictor *makePredictor(const PredictorPoint &point)
+{
+	return makeBranchPredictor(point.type, point.counter, point.tableBits, point.historyBits);
+}
+
+//the config of a parametric pipeline point with the predictor point in place of its own predictor
+ParametricStage::Config withPredictor(const PipelinePoint &pipeline, const PredictorPoint &point)
+{
+	ParametricStage::Config config = pipeline.config;
+	for (int i = 0; i <= ParametricStage::Config::ORACLE; ++i)
+		if (point.type == ParametricStage::Config::predictorNames[i])
+			config.predictor = (ParametricStage::Config::Predictor)i;
+	config.predictorCounter = point.counter;
+	config.predictorTableBits = point.tableBits;
+	config.predictorHistoryBits = point.historyBits;
+	return config;
+}
+
+//a program of the sweep as parsed once, every job on it starts from a copy of image
+struct Program
+{
+	int exitCode = -1; //-1 if the file could not be read, otherwise whether it can run
+	unique_ptr<MIPS_Architecture> image;
+};
+
+void load(const string &fileName, Program &program)
+{
+	bool loaded;
+	program.image.reset(new MIPS_Architecture(fileName, loaded));
+	if (!loaded)
+	{
+		program.image.reset();
+		return;
+	}
+	program.exitCode = program.image->decodeError;
+	if (program.exitCode == MIPS_Architecture::SUCCESS && (long long)program.image->commands.size() >= program.image->addressLimit / 4)
+		program.exitCode = MIPS_Architecture::MEMORY_ERROR;
+}
+
+//arch is the architecture of the worker running the job, made the first time and reset to the program every time after
+MIPS_Architecture *start(const Program &program, unique_ptr<MIPS_Architecture> &arch)
+{
+	if (!arch)
+		arch.reset(new MIPS_Architecture(*program.image));
+	arch->reset(*program.image);
+	arch->outputFormat = 2;
+	return arch.get();
+}
+
+//config is the one to run a parametric point with
+TimingResult runTiming(const Program &program, const PipelinePoint &point, const ParametricStage::Config &config,
+	unique_ptr<MIPS_Architecture> &worker)
+{
+	TimingResult result;
+	result.exitCode = program.exitCode;
+	if (result.exitCode != MIPS_Architecture::SUCCESS)
+		return result;
+	MIPS_Architecture *arch = start(program, worker);
+	if (point.parametric)
+	{
+		ParametricStage::Model model(arch, config);
+		result.cycles = model.run();
+		result.exitCode = model.exitCode;
+		if (config.predictor != ParametricStage::Config::NONE)
+			result.branches = model.branches, result.mispredictions = model.mispredictions;
+	}
+	else
+		result.cycles = point.runPipeline(arch);
+	for (int count : arch->commandCount)
+		result.instructions += count;
+	return result;
+}
+
+PredictorResult runPredictor(const Program &program, const PredictorPoint &point, unique_ptr<MIPS_Architecture> &worker)
+{
+	PredictorResult result;
+	result.exitCode = program.exitCode;
+	if (result.exitCode != MIPS_Architecture::SUCCESS)
+		return result;
+	MIPS_Architecture *arch = start(program, worker);
+	unique_ptr<BranchPredictor> predictor(makePredictor(point));
+	FunctionalModel model(arch);
+	const int *R = arch->registers;
+	while (!model.isDone() && result.exitCode == MIPS_Architecture::SUCCESS)
+	{
+		int pc = arch->PCnext;
+		const Instruction &ins = arch->program[pc];
+		if (ins.op == OP_BEQ || ins.op == OP_BNE)
+		{
+			bool taken = (R[ins.r[0]] == R[ins.r[1]]) == (ins.op == OP_BEQ);
+			result.branches++;
+			if (predictor->predict(pc) != taken)
+				result.mispredictions++;
+			predictor->update(pc, taken);
+		}
+		result.exitCode = model.run(1);
+	}
+	return result;
+}
+
+struct Grid
+{
+	vector<string> programs;
+	vector<PipelinePoint> pipelines;
+	vector<PredictorPoint> predictors; //may be empty, then the table has no predictor columns filled in
+	vector<TimingResult> timing; //[program][pipeline][predictor], only predictor 0 for the hand written pipelines
+	vector<PredictorResult> prediction; //[program][predictor], only run when there are hand written pipelines
+	vector<Program> parsed; //[program]
+	vector<unique_ptr<MIPS_Architecture>> workers; //the architecture of each worker of the pool, made on first use
+
+	size_t predictorSlots() const
+	{
+		return max<size_t>(1, predictors.size());
+	}
+
+	TimingResult &timingOf(size_t program, size_t pipeline, size_t predictor)
+	{
+		if (!pipelines[pipeline].parametric)
+			predictor = 0;
+		return timing[(program * pipelines.size() + pipeline) * predictorSlots() + predictor];
+	}
+
+	//parses every program once, then runs every job on pool and waits for all of them
+	void run(ThreadPool &pool)
+	{
+		parsed.clear();
+		parsed.resize(programs.size());
+		for (size_t p = 0; p < programs.size(); ++p)
+			pool.submit([this, p] { load(programs[p], parsed[p]); });
+		pool.wait();
+		workers.clear();
+		workers.resize(pool.size());
+		timing.assign(programs.size() * pipelines.size() * predictorSlots(), TimingResult());
+		bool handWritten = false;
+		for (PipelinePoint &pipeline : pipelines)
+			handWritten = handWritten || !pipeline.parametric;
+		prediction.assign(handWritten ? programs.size() * predictors.size() : 0, PredictorResult());
+		for (size_t p = 0; p < programs.size(); ++p)
+		{
+			for (size_t i = 0; i < pipelines.size(); ++i)
+				for (size_t j = 0; j < (pipelines[i].parametric ? predictorSlots() : 1); ++j)
+					pool.submit([this, p, i, j, &pool]
+					{
+						PipelinePoint &pipeline = pipelines[i];
+						ParametricStage::Config config = predictors.empty() ? pipeline.config : withPredictor(pipeline, predictors[j]);
+						timingOf(p, i, j) = runTiming(parsed[p], pipeline, config, workers[pool.index()]);
+					});
+			for (size_t i = 0; handWritten && i < predictors.size(); ++i)
+				pool.submit([this, p, i, &pool]
+				{
+					prediction[p * predictors.size() + i] = runPredictor(parsed[p], predictors[i], workers[pool.index()]);
+				});
+		}
+		pool.wait();
+	}
+
+	static string status(int exitCode)
+	{
+		static const char *names[] = {"ok", "invalid_register", "invalid_label", "invalid_address", "syntax_error", "memory_error"};
+		return exitCode < 0 ? "unreadable" : names[exitCode];
+	}
+
+	//one tab separated line per program, pipeline and predictor, in the order they were given. The branch columns of a
+	//parametric pipeline are those of its own run
+	void write(ostream &out)
+	{
+		out << "program\tmodel\tforwarding\tpredictor\tcounter\ttable_bits\thistory_bits\tstatus\tinstructions\tcycles\tcpi\tbranches\tmispredictions\taccuracy\n";
+		out << fixed << setprecision(4);
+		for (size_t p = 0; p < programs.size(); ++p)
+			for (size_t i = 0; i < pipelines.size(); ++i)
+				for (size_t j = 0; j < predictorSlots(); ++j)
+				{
+					TimingResult &t = timingOf(p, i, j);
+					out << programs[p] << '\t' << pipelines[i].model << '\t' << (pipelines[i].forwarding ? "on" : "off") << '\t';
+					PredictorResult *b = nullptr, own;
+					if (t.branches >= 0)
+					{
+						own.branches = t.branches;
+						own.mispredictions = t.mispredictions;
+						b = &own;
+					}
+					const ParametricStage::Config &config = pipelines[i].config;
+					if (predictors.empty() && (!pipelines[i].parametric || config.predictor == ParametricStage::Config::NONE))
+						out << "-\t-\t-\t-\t";
+					else
+					{
+						//without predictor points a parametric pipeline runs the predictor of its config
+						PredictorPoint point = predictors.empty() ? PredictorPoint{ParametricStage::Config::predictorNames[config.predictor],
+							config.predictorCounter, config.predictorTableBits, config.predictorHistoryBits} : predictors[j];
+						if (!pipelines[i].parametric)
+							b = &prediction[p * predictors.size() + j];
+						out << point.type << '\t';
+						if (point.hasCounters())
+							out << point.counter << '\t';
+						else
+							out << "-\t";
+						if (point.hasTable())
+							out << point.tableBits << '\t';
+						else
+							out << "-\t";
+						if (point.hasHistory())
+							out << point.historyBits << '\t';
+						else
+							out << "-\t";
+					}
+					int exitCode = (t.exitCode != MIPS_Architecture::SUCCESS || !b) ? t.exitCode : b->exitCode;
+					out << status(exitCode) << '\t' << t.instructions << '\t' << t.cycles << '\t';
+					if (t.instructions > 0)
+						out << double(t.cycles) / t.instructions;
+					else
+						out << '-';
+					if (b)
+					{
+						out << '\t' << b->branches << '\t' << b->mispredictions << '\t';
+						if (b->branches > 0)
+							out << 1 - double(b->mispredictions) / b->branches;
+						else
+							out << '-';
+					}
+					else
+						out << "\t-\t-\t-";
+					out << '\n';
+				}
+	}
+};
+
+} //namespace Sweep
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef __THREAD_POOL_HPP__
+#define __THREAD_POOL_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//a pool of threads with a queue of tasks each. A worker takes tasks from the back of its own queue and once that is empty
+//steals from the front of the others, so a few long simulations that happened to land on one queue do not leave the
+//other threads idle. Tasks submitted from inside a task go on the queue of the worker running it.
+struct ThreadPool
+{
+	struct Queue
+	{
+		std::mutex lock;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<long long> queued{0}, pending{0}; //tasks waiting in the queues, tasks not finished yet
+	std::atomic<unsigned> nextQueue{0};
+	std::mutex idleLock;
+	std::condition_variable idle, done;
+	bool stopping = false;
+
+	//threads <= 0 means one per hardware thread
+	ThreadPool(int threads = 0)
+	{
+		if (threads <= 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		for (int i = 0; i < threads; ++i)
+			queues.emplace_back(new Queue());
+		for (int i = 0; i < threads; ++i)
+			workers.emplace_back(&ThreadPool::work, this, i);
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> guard(idleLock);
+			stopping = true;
+		}
+		idle.notify_all();
+		for (auto &worker : workers)
+			worker.join();
+	}
+
+	int size()
+	{
+		return workers.size();
+	}
+
+	void submit(std::function<void()> task)
+	{
+		int self = worker(), q = (self >= 0) ? self : nextQueue++ % queues.size();
+		pending++;
+		{
+			std::lock_guard<std::mutex> guard(queues[q]->lock);
+			queues[q]->tasks.push_back(std::move(task));
+		}
+		{
+			std::lock_guard<std::mutex> guard(idleLock); //so a worker deciding to sleep can not miss it
+			queued++;
+		}
+		idle.notify_one();
+	}
+
+	//blocks until every task submitted so far (and whatever they submitted) has finished
+	void wait()
+	{
+		std::unique_lock<std::mutex> guard(idleLock);
+		done.wait(guard, [&] { return pending == 0; });
+	}
+
+	//the index (below size()) of the worker of this pool running on the calling thread, -1 for any other thread, so
+	//tasks can keep per worker state
+	int index()
+	{
+		return worker();
+	}
+
+	private:
+	int worker(int set = -2)
+	{
+		thread_local ThreadPool *pool = nullptr;
+		thread_local int index = -1;
+		if (set != -2)
+			pool = this, index = set;
+		return (pool == this) ? index : -1;
+	}
+
+	bool take(int self, std::function<void()> &task)
+	{
+		for (size_t i = 0; i < queues.size(); ++i)
+		{
+			Queue &q = *queues[(self + i) % queues.size()];
+			std::lock_guard<std::mutex> guard(q.lock);
+			if (q.tasks.empty())
+				continue;
+			if (i == 0) //our own queue, newest first
+			{
+				task = std::move(q.tasks.back());
+				q.tasks.pop_back();
+			}
+			else //stealing, oldest first
+			{
+				task = std::move(q.tasks.front());
+				q.tasks.pop_front();
+			}
+			queued--;
+			return true;
+		}
+		return false;
+	}
+
+	void work(int self)
+	{
+		worker(self);
+		std::function<void()> task;
+		while (true)
+		{
+			if (take(self, task))
+			{
+				task();
+				task = nullptr;
+				if (--pending == 0)
+				{
+					std::lock_guard<std::mutex> guard(idleLock);
+					done.notify_all();
+				}
+				continue;
+			}
+			std::unique_lock<std::mutex> guard(idleLock);
+			idle.wait(guard, [&] { return stopping || queued > 0; });
+			if (stopping && queued == 0)
+				return;
+		}
+	}
+};
+
+#endif
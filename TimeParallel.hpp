@@ -0,0 +1,113 @@
+#ifndef __TIME_PARALLEL_HPP__
+#define __TIME_PARALLEL_HPP__
+
+#include <MIPS_Processor.hpp>
+#include <FunctionalModel.hpp>
+#include <ThreadPool.hpp>
+
+//time parallel simulation of one long run. The functional model counts the instructions of the program, splits them into
+//intervals of equal length and then executes it once more, taking a copy of the architecture (a checkpoint in memory)
+//warmup instructions before each interval starts. Each checkpoint is handed to a ThreadPool as soon as it is taken and a
+//pipeline runs it through the warmup, which refills the latches and the hazard state, and then through its interval,
+//which is timed the way the sampled simulation times its windows. The cycles of the intervals add up to the cycles of
+//the whole run.
+//The instructions before a boundary are run twice, warm at the end of one interval and cold as the warmup of the next,
+//so the difference between the two measures what a cold start costs and is reported as the error estimate.
+struct TimeParallelResult
+{
+	int exitCode = 0;
+	long long instructions = 0, cycles = 0;
+	long long coldStartError = 0; //summed over the boundaries, |cycles of the warmup run cold - the same run warm|
+	long long sequentialCycles = -1; //the cycles of an ordinary run when it was asked for
+	std::vector<long long> intervalCycles;
+};
+
+//runPipeline is the RunPipeline of the timing model, intervals is a number of intervals (fewer if the program is too
+//short) and warmup is counted in instructions (at most the length of an interval). With sequential an ordinary run
+//of the whole program is simulated on the pool as well to check the stitched cycles against.
+//arch ends up in the final state of the program
+TimeParallelResult RunTimeParallel(MIPS_Architecture *arch, int (*runPipeline)(MIPS_Architecture *), int intervals,
+	long long warmup, ThreadPool &pool, bool sequential = false)
+{
+	struct Interval
+	{
+		long long length = 0, warmup = 0, nextWarmup = 0; //the warmup of the next interval overlaps the end of this one
+		long long cycles = 0, warmupCycles = 0, tailCycles = 0;
+		bool last = false;
+	};
+	TimeParallelResult result;
+	auto checkpoint = [arch]()
+	{
+		MIPS_Architecture *copy = new MIPS_Architecture(*arch);
+		copy->trace = nullptr;
+		copy->outputFormat = 2;
+		return copy;
+	};
+	if (sequential)
+	{
+		MIPS_Architecture *copy = checkpoint();
+		pool.submit([copy, runPipeline, &result]
+		{
+			result.sequentialCycles = runPipeline(copy);
+			delete copy;
+		});
+	}
+
+	long long total;
+	{
+		std::unique_ptr<MIPS_Architecture> counter(checkpoint());
+		FunctionalModel model(counter.get());
+		result.exitCode = model.run();
+		total = model.instructionsExecuted;
+	}
+	if (result.exitCode != MIPS_Architecture::SUCCESS || total == 0)
+	{
+		FunctionalModel(arch).run(); //to where the program stops, for the exit message
+		pool.wait();
+		result.instructions = total;
+		return result;
+	}
+
+	intervals = (int)std::max(1LL, std::min<long long>(intervals, total));
+	warmup = std::max(0LL, std::min(warmup, total / intervals));
+	std::vector<Interval> parts(intervals);
+	FunctionalModel model(arch);
+	for (int i = 0; i < intervals; ++i)
+	{
+		long long first = total * i / intervals, next = total * (i + 1) / intervals;
+		Interval &part = parts[i];
+		part.length = next - first;
+		part.warmup = std::min(warmup, first);
+		part.nextWarmup = std::min(warmup, next);
+		part.last = (i == intervals - 1);
+		model.run(first - part.warmup - model.instructionsExecuted);
+		MIPS_Architecture *copy = checkpoint();
+		copy->fetched = 0;
+		copy->fetchLimit = part.last ? -1 : part.warmup + part.length;
+		copy->timedFrom = part.warmup;
+		copy->tailFrom = part.last ? -1 : part.warmup + part.length - part.nextWarmup;
+		copy->timedFromCycle = 0, copy->fetchLimitCycle = -1, copy->tailFromCycle = 0;
+		pool.submit([copy, runPipeline, &part]
+		{
+			long long cycles = runPipeline(copy);
+			part.warmupCycles = copy->timedFromCycle;
+			part.cycles = (part.last ? cycles : copy->fetchLimitCycle) - copy->timedFromCycle;
+			part.tailCycles = part.last ? 0 : copy->fetchLimitCycle - copy->tailFromCycle;
+			delete copy;
+		});
+	}
+	model.run(); //on to the final state while the intervals run
+	pool.wait();
+
+	result.instructions = total;
+	for (int i = 0; i < intervals; ++i)
+	{
+		result.cycles += parts[i].cycles;
+		result.intervalCycles.push_back(parts[i].cycles);
+		if (i > 0)
+			result.coldStartError += std::abs(parts[i].warmupCycles - parts[i - 1].tailCycles);
+	}
+	return result;
+}
+
+#endif
@@ -0,0 +1,462 @@
+#ifndef __TRACE_HPP__
+#define __TRACE_HPP__
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <charconv>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define TRACE_MMAP 1
+#else
+#define TRACE_MMAP 0
+#endif
+
+//binary cycle traces, the same information as the per cycle lines of output format 1 (the registers and the memory write
+//of every cycle) but only what changed is stored. The layout is (all little endian, as written by the host):
+//	"MIPSTRC\0", version, cycles between keyframes
+//	one record per cycle: varint(changed registers mask << 1 | memory write), the zigzag varint delta of every changed
+//	register (lowest first), and for a memory write the zigzag varints of the address and value as printed
+//	the index: the byte offset of every keyframe record
+//	the footer: offset of the index, number of cycles, number of keyframes
+//every keyframeCycles-th record (the first one included) is a keyframe, its deltas are from all registers being zero,
+//so a reader can start decoding there without anything before it and reach any cycle after at most keyframeCycles records
+namespace Trace
+{
+	static const char magic[8] = {'M', 'I', 'P', 'S', 'T', 'R', 'C', 0};
+	static const uint32_t version = 1;
+	static const uint32_t DEFAULT_KEYFRAME_CYCLES = 1024;
+	static const int HEADER_BYTES = 16, FOOTER_BYTES = 24;
+
+	inline uint64_t zigzag(int32_t value)
+	{
+		return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+	}
+	inline int32_t unzigzag(uint64_t value)
+	{
+		return (int32_t)((uint32_t)(value >> 1) ^ (0 - (uint32_t)(value & 1)));
+	}
+
+	//what the pipelines hand over at the end of every cycle, the registers and the memory write as they print it
+	struct CycleRecord
+	{
+		int registers[32];
+		int memWrite, address, value;
+	};
+
+	//appends the two lines output format 1 prints for a cycle
+	inline void formatCycle(std::string &out, const int registers[32], bool memWrite, int address, int value)
+	{
+		size_t start = out.size();
+		out.resize(start + 34 * 12); //enough for the longest lines
+		char *p = &out[start], *end = &out[0] + out.size();
+		for (int i = 0; i < 32; ++i)
+		{
+			p = std::to_chars(p, end, registers[i]).ptr;
+			*p++ = ' ';
+		}
+		*p++ = '\n';
+		if (memWrite)
+		{
+			*p++ = '1';
+			*p++ = ' ';
+			p = std::to_chars(p, end, address).ptr;
+			*p++ = ' ';
+			p = std::to_chars(p, end, value).ptr;
+		}
+		else
+			*p++ = '0';
+		*p++ = '\n';
+		out.resize(p - out.data());
+	}
+
+	//single producer single consumer ring of records. Each side only writes its own index and keeps a cached copy of
+	//the other one, so the shared indices are only read again when the ring looks full (or empty)
+	template <typename T>
+	struct Ring
+	{
+		std::vector<T> slots;
+		size_t mask;
+		alignas(64) std::atomic<size_t> head{0}; //next slot the producer writes
+		size_t cachedTail = 0;
+		alignas(64) std::atomic<size_t> tail{0}; //next slot the consumer reads
+		size_t cachedHead = 0;
+
+		Ring(size_t capacity) //a power of two
+		{
+			slots.resize(capacity);
+			mask = capacity - 1;
+		}
+		bool push(const T &item)
+		{
+			size_t h = head.load(std::memory_order_relaxed);
+			if (h - cachedTail == slots.size())
+			{
+				cachedTail = tail.load(std::memory_order_acquire);
+				if (h - cachedTail == slots.size())
+					return false;
+			}
+			slots[h & mask] = item;
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+		//the slot to read next, nullptr if the ring is empty. pop() releases it once it has been used
+		const T *front()
+		{
+			size_t t = tail.load(std::memory_order_relaxed);
+			if (t == cachedHead)
+			{
+				cachedHead = head.load(std::memory_order_acquire);
+				if (t == cachedHead)
+					return nullptr;
+			}
+			return &slots[t & mask];
+		}
+		void pop()
+		{
+			tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+	};
+
+	//takes the records of the pipelines and writes them out on a thread of its own, either as a binary trace (open) or as
+	//the text of output format 1 (openText). The pipeline only waits when the ring is full
+	struct Writer
+	{
+		static const size_t RING_RECORDS = 1 << 13;
+
+		std::ofstream file;
+		std::ostream *out = nullptr;
+		bool text = false;
+		std::vector<uint8_t> buffer; //written out in large blocks, the records are only a few bytes each
+		std::string textBuffer;
+		std::vector<uint64_t> keyframes;
+		uint64_t written = 0; //bytes already in the file
+		uint32_t keyframeCycles = DEFAULT_KEYFRAME_CYCLES;
+		long long cycles = 0;
+		int last[32] = {0};
+
+		std::ostream *tied = nullptr; //what cerr was tied to before openText, a write to cerr would flush out on this thread
+		Ring<CycleRecord> ring{RING_RECORDS};
+		std::thread worker;
+		std::atomic<bool> closing{false};
+		bool finished = false;
+
+		//returns false (with a message on cerr) if the file can not be created
+		bool open(const std::string &fileName, uint32_t keyframeCycles = DEFAULT_KEYFRAME_CYCLES)
+		{
+			this->keyframeCycles = keyframeCycles;
+			file.open(fileName, std::ios::binary);
+			if (!file.is_open())
+			{
+				std::cerr << "Could not open trace " << fileName << " for writing\n";
+				return false;
+			}
+			out = &file;
+			buffer.insert(buffer.end(), magic, magic + sizeof(magic));
+			put32(version);
+			put32(keyframeCycles);
+			worker = std::thread(&Writer::drain, this);
+			return true;
+		}
+		//nothing else may be written to stream until finish()
+		void openText(std::ostream &stream)
+		{
+			out = &stream;
+			text = true;
+			tied = std::cerr.tie(nullptr);
+			worker = std::thread(&Writer::drain, this);
+		}
+		~Writer()
+		{
+			finish();
+		}
+
+		//called by the pipelines at the end of every cycle, with the memory write as they print it
+		void cycle(const int registers[32], bool memWrite, int address, int value)
+		{
+			CycleRecord record;
+			memcpy(record.registers, registers, sizeof(record.registers));
+			record.memWrite = memWrite;
+			record.address = address;
+			record.value = value;
+			while (!ring.push(record))
+				std::this_thread::yield();
+		}
+
+		//waits for the thread to write everything, then writes the index and footer (the trace can only be read after this)
+		bool finish()
+		{
+			if (finished || !out)
+				return true;
+			finished = true;
+			closing.store(true, std::memory_order_release);
+			worker.join();
+			if (text)
+			{
+				out->write(textBuffer.data(), textBuffer.size());
+				out->flush();
+				std::cerr.tie(tied);
+				return !out->fail();
+			}
+			uint64_t indexOffset = written + buffer.size();
+			for (uint64_t offset : keyframes)
+				put64(offset);
+			put64(indexOffset);
+			put64(cycles);
+			put64(keyframes.size());
+			flush();
+			file.close();
+			return !file.fail();
+		}
+
+		//the writer thread, runs until finish() once everything is written. It backs off to short sleeps when the
+		//pipeline is not producing, so it does not hold on to a core through a quiet run
+		void drain()
+		{
+			int idle = 0;
+			while (true)
+			{
+				const CycleRecord *record = ring.front();
+				if (record)
+				{
+					idle = 0;
+					if (text)
+						formatCycle(textBuffer, record->registers, record->memWrite, record->address, record->value);
+					else
+						encode(*record);
+					ring.pop();
+					if (buffer.size() >= (1 << 16) || textBuffer.size() >= (1 << 16))
+						flush();
+				}
+				else if (closing.load(std::memory_order_acquire))
+				{
+					if (!ring.front()) //anything pushed before closing is visible by now
+						return;
+				}
+				else if (++idle < 64)
+					std::this_thread::yield();
+				else
+					std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		}
+
+		void encode(const CycleRecord &record)
+		{
+			if (cycles % keyframeCycles == 0)
+			{
+				keyframes.push_back(written + buffer.size());
+				memset(last, 0, sizeof(last));
+			}
+			++cycles;
+			uint32_t mask = 0;
+			for (int i = 0; i < 32; ++i)
+				if (record.registers[i] != last[i])
+					mask |= 1u << i;
+			putVarint(((uint64_t)mask << 1) | (record.memWrite != 0));
+			for (uint32_t m = mask; m; m &= m - 1)
+			{
+				int i = __builtin_ctz(m);
+				putVarint(zigzag((int32_t)((uint32_t)record.registers[i] - (uint32_t)last[i])));
+				last[i] = record.registers[i];
+			}
+			if (record.memWrite)
+			{
+				putVarint(zigzag(record.address));
+				putVarint(zigzag(record.value));
+			}
+		}
+
+		void flush()
+		{
+			if (text)
+			{
+				out->write(textBuffer.data(), textBuffer.size());
+				textBuffer.clear();
+				return;
+			}
+			out->write((const char *)buffer.data(), buffer.size());
+			written += buffer.size();
+			buffer.clear();
+		}
+		void putVarint(uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				buffer.push_back((uint8_t)(value | 0x80));
+				value >>= 7;
+			}
+			buffer.push_back((uint8_t)value);
+		}
+		void put32(uint32_t value)
+		{
+			buffer.insert(buffer.end(), (uint8_t *)&value, (uint8_t *)&value + sizeof(value));
+		}
+		void put64(uint64_t value)
+		{
+			buffer.insert(buffer.end(), (uint8_t *)&value, (uint8_t *)&value + sizeof(value));
+		}
+	};
+
+	//reads a trace written by Writer, mapped when possible. After seek(n) (or n calls to next()) the state is that at
+	//the end of cycle n
+	struct Reader
+	{
+		std::vector<char> copy; //the file, when it could not be mapped
+		const uint8_t *data = nullptr, *p = nullptr, *recordsEnd = nullptr;
+		size_t size = 0;
+		bool mapped = false;
+		uint32_t keyframeCycles = 0;
+		long long cycles = 0, cycle = 0;
+		const uint8_t *index = nullptr; //the keyframe offsets, read with memcpy since they need not be aligned
+		uint64_t keyframeCount = 0;
+
+		int registers[32] = {0};
+		bool memWrite = false;
+		int address = 0, value = 0;
+
+		~Reader()
+		{
+#if TRACE_MMAP
+			if (mapped)
+				munmap((void *)data, size);
+#endif
+		}
+
+		//returns false (with a message on cerr) if the file is not a complete trace
+		bool open(const std::string &fileName)
+		{
+#if TRACE_MMAP
+			int fd = ::open(fileName.c_str(), O_RDONLY);
+			struct stat status;
+			if (fd >= 0 && fstat(fd, &status) == 0 && status.st_size > 0)
+			{
+				void *m = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (m != MAP_FAILED)
+				{
+					data = (const uint8_t *)m;
+					size = status.st_size;
+					mapped = true;
+				}
+			}
+			if (fd >= 0)
+				close(fd);
+#endif
+			if (!mapped)
+			{
+				std::ifstream in(fileName, std::ios::binary);
+				if (!in.is_open())
+				{
+					std::cerr << "Could not open trace " << fileName << '\n';
+					return false;
+				}
+				copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+				data = (const uint8_t *)copy.data();
+				size = copy.size();
+			}
+			uint32_t fileVersion = 0;
+			uint64_t indexOffset = 0, fileCycles = 0;
+			bool ok = size >= HEADER_BYTES + FOOTER_BYTES && memcmp(data, magic, sizeof(magic)) == 0;
+			if (ok)
+			{
+				memcpy(&fileVersion, data + 8, 4);
+				memcpy(&keyframeCycles, data + 12, 4);
+				memcpy(&indexOffset, data + size - 24, 8);
+				memcpy(&fileCycles, data + size - 16, 8);
+				memcpy(&keyframeCount, data + size - 8, 8);
+				ok = fileVersion == version && keyframeCycles > 0 && indexOffset >= HEADER_BYTES &&
+					 indexOffset + keyframeCount * 8 + FOOTER_BYTES == size &&
+					 keyframeCount == (fileCycles + keyframeCycles - 1) / keyframeCycles;
+			}
+			if (!ok)
+			{
+				std::cerr << fileName << " is not a complete trace of this version\n";
+				return false;
+			}
+			cycles = fileCycles;
+			recordsEnd = data + indexOffset;
+			index = recordsEnd;
+			p = data + HEADER_BYTES;
+			return true;
+		}
+
+		//moves to the end of cycle n (0 is before the first cycle), false if there is no such cycle
+		bool seek(long long n)
+		{
+			if (n < 0 || n > cycles)
+				return false;
+			cycle = 0;
+			p = data + HEADER_BYTES;
+			memset(registers, 0, sizeof(registers));
+			memWrite = false;
+			if (n == 0)
+				return true;
+			uint64_t keyframe = (n - 1) / keyframeCycles, offset;
+			memcpy(&offset, index + 8 * keyframe, 8);
+			if (offset < HEADER_BYTES || data + offset >= recordsEnd)
+				return false;
+			p = data + offset;
+			cycle = keyframe * keyframeCycles;
+			while (cycle < n)
+				if (!next())
+					return false;
+			return true;
+		}
+
+		//decodes the next cycle, false at the end of the trace or if it is damaged
+		bool next()
+		{
+			if (cycle >= cycles || p >= recordsEnd)
+				return false;
+			if (cycle % keyframeCycles == 0)
+				memset(registers, 0, sizeof(registers));
+			uint64_t header;
+			if (!getVarint(header))
+				return false;
+			uint32_t mask = header >> 1;
+			memWrite = header & 1;
+			for (uint32_t m = mask; m; m &= m - 1)
+			{
+				uint64_t delta;
+				if (!getVarint(delta))
+					return false;
+				int i = __builtin_ctz(m);
+				registers[i] = (int)((uint32_t)registers[i] + (uint32_t)unzigzag(delta));
+			}
+			if (memWrite)
+			{
+				uint64_t a, v;
+				if (!getVarint(a) || !getVarint(v))
+					return false;
+				address = unzigzag(a);
+				value = unzigzag(v);
+			}
+			++cycle;
+			return true;
+		}
+
+		bool getVarint(uint64_t &result)
+		{
+			result = 0;
+			for (int shift = 0; p < recordsEnd && shift < 64; shift += 7)
+			{
+				uint8_t byte = *p++;
+				result |= (uint64_t)(byte & 0x7f) << shift;
+				if (!(byte & 0x80))
+					return true;
+			}
+			return false;
+		}
+	};
+}
+
+#endif
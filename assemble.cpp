@@ -0,0 +1,27 @@
+#include<MIPS_Processor.hpp>
+#include<RunOptions.hpp>
+using namespace std;
+
+//assembles the program once into an object file that every binary accepts in place of the source, so a program that is
+//run many times is only parsed once. Constant addresses are checked against --memory, pass the one the runs will use
+int main(int argc, char *argv[])
+{
+	RunOptions options;
+	if (!options.parse(argc, argv) || options.rest.size() != 1 || !options.resume.empty() || !options.images.empty())
+	{
+		std::cerr << "Required arguments: file_name object_name\n./assembleFinal <file name> <object name> [--memory <bytes>]\n";
+		return 0;
+	}
+	Assembler assembler(options.memory);
+	if (!assembler.assembleFile(options.fileName))
+	{
+		std::cerr << "File could not be opened. Terminating...\n";
+		return 0;
+	}
+	if (!assembler.writeObject(options.rest[0]))
+		return 0;
+	cout << "Assembled " << assembler.commands.size() << " commands into " << options.rest[0] << '\n';
+	if (assembler.error != Assembler::SUCCESS)
+		cout << "Command " << assembler.errorCommand << " (line " << assembler.lines[assembler.errorCommand] << ") has an error, which running the object will report\n";
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include<Batch.hpp>
+#include<chrono>
+using namespace std;
+
+static const char *usage = "./batchFinal <5stage|5stage_bypass|79stage|config> <manifest or directory>... [--threads <n>] [--out <file>]";
+
+//runs one pipeline on every program of a corpus in one process and writes a line per program with its status,
+//instructions executed, cycles and a hash of its final registers and memory. The corpus is given by manifests (a file
+//name per line) or directories (every .asm and .obj file under them)
+int main(int argc, char *argv[])
+{
+	Batch::Runner runner;
+	vector<string> corpus;
+	int threads = 0;
+	string out;
+	bool argsOk = argc >= 3;
+	for (int i = 2; i < argc && argsOk; ++i)
+	{
+		string arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc)
+		{
+			threads = atoi(argv[++i]);
+			argsOk = threads > 0;
+		}
+		else if (arg == "--out" && i + 1 < argc)
+			out = argv[++i];
+		else if (arg.substr(0, 2) == "--")
+			argsOk = false;
+		else
+			corpus.push_back(arg);
+	}
+	if (!argsOk || corpus.empty())
+	{
+		std::cerr << "Required arguments: model manifest_or_directory\n" << usage << "\n";
+		return 0;
+	}
+	if (!runner.setModel(argv[1]))
+		return 0; //the config said what is wrong with it
+	for (string &path : corpus)
+		if (!Batch::listPrograms(path, runner.programs))
+		{
+			std::cerr << "Could not read the manifest or directory " << path << '\n';
+			return 0;
+		}
+
+	ofstream file;
+	if (out != "")
+	{
+		file.open(out);
+		if (!file.is_open())
+		{
+			std::cerr << "Could not write " << out << '\n';
+			return 0;
+		}
+	}
+	auto start = chrono::steady_clock::now();
+	ThreadPool pool(threads);
+	runner.run(pool, out == "" ? cout : file);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	std::cerr << runner.programs.size() << " programs, " << runner.cache.parses << " parsed, " << pool.size() << " threads, "
+		<< seconds << "s\n";
+	return 0;
+}
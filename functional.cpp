@@ -0,0 +1,52 @@
+#include<MIPS_Processor.hpp>
+#include<FunctionalModel.hpp>
+#include<RunOptions.hpp>
+using namespace std;
+
+//runs the program on the non pipelined functional model, only the final state is printed.
+//--save n file stops after n instructions and writes a checkpoint instead, which any of the pipelines can --resume from
+int main(int argc, char *argv[])
+{
+	RunOptions options;
+	bool argsOk = options.parse(argc, argv);
+	long long saveAfter = -1;
+	string save;
+	if (argsOk && options.rest.size() == 3 && options.rest[0] == "--save")
+	{
+		saveAfter = atoll(options.rest[1].c_str());
+		save = options.rest[2];
+		argsOk = (saveAfter >= 0);
+	}
+	else if (!options.rest.empty())
+		argsOk = false;
+	argsOk = argsOk && options.trace.empty() && options.caches.empty(); //there are no cycles to trace or time
+	if (!argsOk)
+	{
+		std::cerr << "Required argument: file_name\n./functionalFinal <file name> " << RunOptions::usage << " [--save <instructions> <checkpoint>]\n";
+		return 0;
+	}
+	MIPS_Architecture *mips = options.load();
+	if (!mips)
+		return 0;
+
+	if (save == "")
+	{
+		ExecuteFunctional(mips);
+		return 0;
+	}
+	if (mips->decodeError != mips->SUCCESS)
+	{
+		mips->handleExit(mips->decodeError, 0);
+		return 0;
+	}
+	FunctionalModel model(mips);
+	int code = model.run(saveAfter);
+	if (code != mips->SUCCESS)
+	{
+		mips->handleExit((MIPS_Architecture::exit_code)code, model.instructionsExecuted);
+		return 0;
+	}
+	if (Checkpoint::save(mips, save))
+		cout << "Saved checkpoint " << save << " after " << model.instructionsExecuted << " instructions, next command " << mips->PCnext << '\n';
+	return 0;
+}
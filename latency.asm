@@ -0,0 +1,47 @@
+# a lw waiting on memory while more alu instructions retire past it than the pipeline has stages, then one that uses
+# what it loads. The add must not write $t2 before the lw writes $t0, and the sw ahead of them waits for memory too
+addi $s6, $zero, 2048
+addi $t5, $zero, 7
+sw $t5, 0($s6)
+lw $t0, 0($s6)
+addi $t1, $t3, 1
+addi $t1, $t3, 2
+addi $t1, $t3, 3
+addi $t1, $t3, 4
+addi $t1, $t3, 5
+addi $t1, $t3, 6
+addi $t1, $t3, 7
+addi $t1, $t3, 8
+addi $t1, $t3, 9
+addi $t1, $t3, 10
+addi $t1, $t3, 11
+addi $t1, $t3, 12
+addi $t1, $t3, 13
+addi $t1, $t3, 14
+addi $t1, $t3, 15
+addi $t1, $t3, 16
+addi $t1, $t3, 17
+addi $t1, $t3, 18
+addi $t1, $t3, 19
+addi $t1, $t3, 20
+addi $t1, $t3, 21
+addi $t1, $t3, 22
+addi $t1, $t3, 23
+addi $t1, $t3, 24
+addi $t1, $t3, 25
+addi $t1, $t3, 26
+addi $t1, $t3, 27
+addi $t1, $t3, 28
+addi $t1, $t3, 29
+addi $t1, $t3, 30
+addi $t1, $t3, 31
+addi $t1, $t3, 32
+addi $t1, $t3, 33
+addi $t1, $t3, 34
+addi $t1, $t3, 35
+addi $t1, $t3, 36
+addi $t1, $t3, 37
+addi $t1, $t3, 38
+addi $t1, $t3, 39
+addi $t1, $t3, 40
+add $t2, $t0, $t0
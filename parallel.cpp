@@ -0,0 +1,88 @@
+#include<MIPS_Processor.hpp>
+#include<TimeParallel.hpp>
+#include<5stage.hpp>
+#include<5stage_bypass.hpp>
+#include<79stage.hpp>
+#include<RunOptions.hpp>
+using namespace std;
+
+//runs one long program on one of the pipelines split into intervals that are simulated side by side, and reports the
+//stitched number of cycles with an estimate of its error
+int main(int argc, char *argv[])
+{
+	RunOptions options;
+	int threads = 0;
+	bool check = false;
+	vector<string> numbers;
+	bool argsOk = argc >= 2 && options.parse(argc - 1, argv + 1) && options.trace.empty();
+	for (size_t i = 0; argsOk && i < options.rest.size(); ++i)
+	{
+		if (options.rest[i] == "--threads" && i + 1 < options.rest.size())
+		{
+			threads = atoi(options.rest[++i].c_str());
+			argsOk = threads > 0;
+		}
+		else if (options.rest[i] == "--check")
+			check = true;
+		else
+			numbers.push_back(options.rest[i]);
+	}
+	if (!argsOk || (numbers.size() != 0 && numbers.size() != 2))
+	{
+		std::cerr << "Required arguments: model file_name [intervals warmup]\n./parallelFinal <5stage|5stage_bypass|79stage> <file name> [intervals warmup] [--threads <n>] [--check] " << RunOptions::usage << "\n";
+		return 0;
+	}
+	string modelName = argv[1];
+	int (*runPipeline)(MIPS_Architecture *);
+	if (modelName == "5stage")
+		runPipeline = FiveStage::RunPipeline;
+	else if (modelName == "5stage_bypass")
+		runPipeline = FiveStageBypass::RunPipeline;
+	else if (modelName == "79stage")
+		runPipeline = SevenNineStage::RunPipeline;
+	else
+	{
+		std::cerr << "Unknown model " << modelName << ", expected 5stage, 5stage_bypass or 79stage\n";
+		return 0;
+	}
+	ThreadPool pool(threads);
+	long long intervals = pool.size(), warmup = 100; //one interval per thread, warmup in instructions
+	if (numbers.size() == 2)
+	{
+		intervals = atoll(numbers[0].c_str()); warmup = atoll(numbers[1].c_str());
+		if (intervals <= 0 || intervals > (1 << 20) || warmup < 0)
+		{
+			std::cerr << "Need 0 < intervals <= 1048576 and warmup >= 0\n";
+			return 0;
+		}
+	}
+	MIPS_Architecture *mips = options.load();
+	if (!mips)
+		return 0;
+	if (mips->decodeError != mips->SUCCESS)
+	{
+		mips->handleExit(mips->decodeError, 0);
+		return 0;
+	}
+	if ((long long)mips->commands.size() >= mips->addressLimit / 4)
+	{
+		mips->handleExit(mips->MEMORY_ERROR, 0);
+		return 0;
+	}
+
+	TimeParallelResult result = RunTimeParallel(mips, runPipeline, intervals, warmup, pool, check);
+	mips->handleExit((MIPS_Architecture::exit_code)result.exitCode, result.cycles);
+	cout << "\nTime parallel simulation on " << modelName << ", " << result.intervalCycles.size() << " intervals, warmup "
+		<< warmup << ", " << pool.size() << " threads\n";
+	cout << "Instructions executed: " << result.instructions << '\n';
+	cout << "Cycles: " << result.cycles << '\n';
+	if (warmup == 0 && result.intervalCycles.size() > 1)
+		cout << "No error estimate without a warmup\n";
+	else if (result.cycles > 0)
+		cout << "Error estimate: +- " << result.coldStartError << " (" << 100.0 * result.coldStartError / result.cycles
+			<< "%), what a cold start at the boundaries would cost without the warmup\n";
+	if (result.sequentialCycles >= 0)
+		cout << "Sequential run: " << result.sequentialCycles << " cycles, the stitched cycles are off by "
+			<< result.cycles - result.sequentialCycles << " (" << 100.0 * (result.cycles - result.sequentialCycles) / max(1LL, result.sequentialCycles) << "%)\n";
+	return 0;
+}
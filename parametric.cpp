@@ -0,0 +1,24 @@
+#include<parametric.hpp>
+#include<RunOptions.hpp>
+using namespace std;
+
+//runs the program on the pipeline described by a config file (see pipeline.cfg), so that trying another depth is a
+//change to the config rather than a new model
+int main(int argc, char *argv[])
+{
+	RunOptions options;
+	if (argc < 3 || !options.parse(argc - 1, argv + 1) || !options.rest.empty())
+	{
+		std::cerr << "Required arguments: config file_name\n./parametricFinal <config> <file name> " << RunOptions::usage << "\n";
+		return 0;
+	}
+	ParametricStage::Config config;
+	if (!config.load(argv[1]))
+		return 0;
+	MIPS_Architecture *mips = options.load();
+	if (!mips)
+		return 0;
+
+	ParametricStage::ExecutePipelined(mips, config);
+	return 0;
+}
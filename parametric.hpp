@@ -0,0 +1,893 @@
+#ifndef __PARAMETRIC_HPP__
+#define __PARAMETRIC_HPP__
+
+#include <MIPS_Processor.hpp>
+#include <BranchPredictor.hpp>
+#include <climits>
+#include <sstream>
+
+//a pipeline whose depth comes from a config file instead of being written out by hand. Every instruction goes through
+//fetch_depth IF stages, decode_depth ID stages (the registers are read in the last one), alu_latency EX stages,
+//memory_depth DM stages and WB, spending a cycle in each unless it stalls, and a stalled instruction holds up everything
+//behind it. lw and sw always go through DM, with alu_skips_memory the other instructions go from EX straight to WB (the
+//7/9 stage split). The defaults are the 7/9 stage pipeline of 79stage.hpp and take the same cycles on every program.
+//None of the stall distances are written down anywhere, they follow from when values exist:
+//	- an instruction waits in its last ID stage until the registers it reads are available, or with read_stage in the
+//	  one before it until they are in the last one (the RR stage of 79stage.hpp). Without forwarding they are the cycle
+//	  after their producers write back, or the same cycle with split_cycle (WB writes in the first half of a cycle and
+//	  ID reads in the second). With forwarding they are the cycle after the producer's last EX stage (last DM stage for
+//	  lw), and sw only needs its data when it gets to DM
+//	- fetch stops after a control instruction until it resolves, j in ID stage target_stage, beq and bne in the last ID
+//	  stage or the last EX stage depending on branch_stage (in ID they need their registers there, forwarded or not)
+//	- with a predictor fetch goes on past a beq or bne predicted not taken, and from its target once it is decoded in ID
+//	  stage target_stage when it is predicted taken. After a misprediction the commands down the wrong path are fetched
+//	  (they fill the stages and the instruction cache but are never executed) and thrown away when the branch resolves,
+//	  fetch then starts over on the right path in the next cycle
+//	- a lw or sw spends memory_latency cycles in the last DM stage, everything behind it waits. With caches (see Cache.hpp)
+//	  it spends as long as the data cache takes instead, and a command spends as long in the first IF stage as the
+//	  instruction cache takes to fetch it
+//	- WB has a single write port, an instruction skipping DM waits in EX while an older one leaves DM, and it never
+//	  writes back before an older instruction that writes the same register. With writeback_in_order it waits in ID
+//	  instead until it can not get to WB before an older lw or sw (nor together with an older lw when both write), as
+//	  the ID stage of 79stage.hpp does. When the alu instructions skip DM the instructions that write no register (sw,
+//	  beq, bne and j) go by WB in the cycle after their last DM or EX stage without taking the port
+//the instructions are executed in program order when they are fetched, the stages only decide when their results show
+//up in the registers, so the final state is always that of the functional model.
+//Only the stages holding an instruction are looked at in a cycle, and once a cycle goes by in which nothing moves (all
+//of the pipeline is waiting on a memory access, say) the clock jumps straight to the next cycle in which something can,
+//the cycles in between are still counted and printed one by one.
+namespace ParametricStage
+{
+
+struct Config
+{
+	enum BranchStage
+	{
+		DECODE,
+		EXECUTE
+	};
+	enum Predictor
+	{
+		NONE, //fetch waits for every beq and bne to resolve
+		NOT_TAKEN,
+		SATURATING,
+		BHR,
+		SATURATING_BHR,
+		GSHARE,
+		TOURNAMENT,
+		HYBRID,
+		TAGE,
+		PERCEPTRON,
+		ORACLE //always right, the most prediction can save
+	};
+	static constexpr const char *predictorNames[] = {"none", "not_taken", "saturating", "bhr", "saturating_bhr", "gshare",
+		"tournament", "hybrid", "tage", "perceptron", "oracle"};
+	static const int MAX_DEPTH = 64, MAX_LATENCY = 100000, MAX_BTB = 1 << 20;
+	int fetchDepth = 2, decodeDepth = 3, aluLatency = 1, memoryDepth = 2; //the 7/9 stage pipeline
+	int targetStage = 2; //the ID stage (from 1) a j or a branch predicted taken gets its target in, the last if there are fewer
+	int memoryLatency = 1; //cycles a lw or sw spends in the last DM stage
+	bool forwarding = false, aluSkipsMemory = true;
+	bool splitCycle = false; //WB writes in the first half of a cycle and ID reads in the second
+	bool writebackInOrder = true; //nothing skipping DM gets to WB before an older lw or sw
+	bool readStage = true; //the last ID stage only reads the registers (RR), instructions wait for them in the one before
+	BranchStage branchStage = EXECUTE;
+	Predictor predictor = NONE;
+	int predictorCounter = 0, predictorTableBits = 14; //the state the counters start in, 2^bits counters in a table
+	int predictorHistoryBits = 12; //the branches gshare, tournament, hybrid and perceptron remember
+	TageConfig tage; //its base table is predictor_table_bits wide
+	int btbEntries = 0, btbWays = 1, btbTagBits = 30; //no branch target buffer unless it has entries
+
+	//lines of key = value, # starts a comment. Returns false (after saying what is wrong) if the file can not be read or
+	//has a key it does not know or a value out of range, the keys that are not given keep their defaults
+	bool load(const string &fileName)
+	{
+		ifstream file(fileName);
+		if (!file.is_open())
+		{
+			cerr << "Config " << fileName << " could not be opened\n";
+			return false;
+		}
+		string line;
+		for (int number = 1; getline(file, line); ++number)
+		{
+			line = line.substr(0, line.find('#'));
+			for (char &c : line)
+				if (c == '=')
+					c = ' ';
+			istringstream words(line);
+			string key, value, extra;
+			if (!(words >> key))
+				continue;
+			if (!(words >> value) || (words >> extra) || !set(key, value))
+			{
+				cerr << "Line " << number << " of config " << fileName << ": expected one of\n"
+					 << "\tfetch_depth, decode_depth, alu_latency, memory_depth, target_stage = 1 to " << MAX_DEPTH << "\n"
+					 << "\tmemory_latency = 1 to " << MAX_LATENCY << "\n"
+					 << "\tforwarding, alu_skips_memory, split_cycle, writeback_in_order, read_stage = on or off\n"
+					 << "\tbranch_stage = decode or execute\n"
+					 << "\tpredictor = none, not_taken, saturating, bhr, saturating_bhr, gshare, tournament, hybrid, tage, perceptron\n"
+					 << "\t\tor oracle\n"
+					 << "\tpredictor_counter = 0 to 3, predictor_table_bits = 1 to 24\n"
+					 << "\tpredictor_history_bits = 1 to 24, up to 1024 for perceptron\n"
+					 << "\ttage_tables = 1 to 16, tage_table_bits = 1 to 20, tage_min_history, tage_max_history = 1 to 1024,\n"
+					 << "\ttage_tag_bits = 2 to 16, tage_reset_bits = 1 to 30\n"
+					 << "\tbtb_entries = 0 or a power of two up to " << MAX_BTB << ", btb_ways = a power of two, btb_tag_bits = 0 to 30\n";
+				return false;
+			}
+		}
+		if (predictorHistoryBits > 24 && predictor != PERCEPTRON)
+		{
+			cerr << "Config " << fileName << ": only the perceptron takes more than 24 predictor_history_bits\n";
+			return false;
+		}
+		if (predictor == PERCEPTRON && !PerceptronBranchPredictor::fits(predictorTableBits, predictorHistoryBits))
+		{
+			cerr << "Config " << fileName << ": a perceptron of 2^" << predictorTableBits << " rows of " << predictorHistoryBits
+				 << " history bits takes more than " << (PerceptronBranchPredictor::MAX_WEIGHTS >> 20) << "MB of weights\n";
+			return false;
+		}
+		if (tage.minHistory > tage.maxHistory)
+		{
+			cerr << "Config " << fileName << ": tage_min_history is more than tage_max_history\n";
+			return false;
+		}
+		if (btbWays > btbEntries && btbEntries > 0)
+		{
+			cerr << "Config " << fileName << ": a branch target buffer of " << btbEntries << " entries can not have " << btbWays << " ways\n";
+			return false;
+		}
+		return true;
+	}
+
+	bool set(const string &key, const string &value)
+	{
+		int *depth = (key == "fetch_depth") ? &fetchDepth : (key == "decode_depth") ? &decodeDepth
+			: (key == "alu_latency") ? &aluLatency : (key == "memory_depth") ? &memoryDepth
+			: (key == "target_stage") ? &targetStage : nullptr;
+		bool *flag = (key == "forwarding") ? &forwarding : (key == "alu_skips_memory") ? &aluSkipsMemory
+			: (key == "split_cycle") ? &splitCycle : (key == "writeback_in_order") ? &writebackInOrder
+			: (key == "read_stage") ? &readStage : nullptr;
+		if (depth)
+		{
+			if (value.find_first_not_of("0123456789") != string::npos || value.size() > 2)
+				return false;
+			*depth = stoi(value);
+			return *depth >= 1 && *depth <= MAX_DEPTH;
+		}
+		if (key == "memory_latency")
+		{
+			if (value.find_first_not_of("0123456789") != string::npos || value.size() > 6)
+				return false;
+			memoryLatency = stoi(value);
+			return memoryLatency >= 1 && memoryLatency <= MAX_LATENCY;
+		}
+		if (flag)
+		{
+			if (value != "on" && value != "off" && value != "1" && value != "0")
+				return false;
+			*flag = (value == "on" || value == "1");
+			return true;
+		}
+		if (key == "branch_stage" && (value == "decode" || value == "execute"))
+		{
+			branchStage = (value == "decode") ? DECODE : EXECUTE;
+			return true;
+		}
+		if (key == "predictor")
+		{
+			for (int i = 0; i <= ORACLE; ++i)
+				if (value == predictorNames[i])
+				{
+					predictor = (Predictor)i;
+					return true;
+				}
+			return false;
+		}
+		if (key == "predictor_counter" || key == "predictor_table_bits" || key == "predictor_history_bits")
+		{
+			if (value.find_first_not_of("0123456789") != string::npos || value.empty() || value.size() > 4)
+				return false;
+			int &n = (key == "predictor_counter") ? predictorCounter : (key == "predictor_table_bits") ? predictorTableBits
+				: predictorHistoryBits;
+			n = stoi(value);
+			return (key == "predictor_counter") ? n <= 3 : (n >= 1 && n <= (key == "predictor_table_bits" ? 24 : 1024));
+		}
+		if (key.substr(0, 5) == "tage_")
+		{
+			//the key, what it sets and its range
+			struct { const char *key; int *value, low, high; } keys[] = {{"tage_tables", &tage.tables, 1, 16},
+				{"tage_table_bits", &tage.tableBits, 1, 20}, {"tage_min_history", &tage.minHistory, 1, 1024},
+				{"tage_max_history", &tage.maxHistory, 1, 1024}, {"tage_tag_bits", &tage.tagBits, 2, 16},
+				{"tage_reset_bits", &tage.resetBits, 1, 30}};
+			for (auto &k : keys)
+				if (key == k.key)
+				{
+					if (value.find_first_not_of("0123456789") != string::npos || value.empty() || value.size() > 4)
+						return false;
+					*k.value = stoi(value);
+					return *k.value >= k.low && *k.value <= k.high;
+				}
+			return false;
+		}
+		if (key == "btb_entries" || key == "btb_ways" || key == "btb_tag_bits")
+		{
+			if (value.find_first_not_of("0123456789") != string::npos || value.empty() || value.size() > 7)
+				return false;
+			int &n = (key == "btb_entries") ? btbEntries : (key == "btb_ways") ? btbWays : btbTagBits;
+			n = stoi(value);
+			if (key == "btb_tag_bits")
+				return n <= 30;
+			return (n & (n - 1)) == 0 && n <= MAX_BTB && (n > 0 || key == "btb_entries");
+		}
+		return false;
+	}
+
+	int stages() const
+	{
+		return fetchDepth + decodeDepth + aluLatency + memoryDepth + 1;
+	}
+
+	//IF0 IF1 ID0 ... WB, a group of one stage has no number and a read stage is RR
+	string stageName(int stage) const
+	{
+		bool rr = readStage && decodeDepth > 1;
+		if (rr && stage == fetchDepth + decodeDepth - 1)
+			return "RR";
+		int depths[4] = {fetchDepth, decodeDepth, aluLatency, memoryDepth};
+		int named[4] = {fetchDepth, decodeDepth - rr, aluLatency, memoryDepth}; //the stages of a group numbered
+		const char *names[4] = {"IF", "ID", "EX", "DM"};
+		for (int group = 0; group < 4; stage -= depths[group++])
+			if (stage < depths[group])
+				return named[group] == 1 ? string(names[group]) : names[group] + to_string(stage);
+		return "WB";
+	}
+
+	//the stall cycles between two back to back instructions and the bubbles after a control instruction, as they follow
+	//from the depths
+	void describe(ostream &out) const
+	{
+		int dm = aluSkipsMemory ? 0 : memoryDepth;
+		out << "Stages:";
+		for (int s = 0; s < stages(); ++s)
+			out << ' ' << stageName(s);
+		int late = splitCycle ? 0 : 1; //reading a cycle after WB
+		out << "\nStalls when the next instruction uses the result of an alu instruction: "
+			<< (forwarding ? aluLatency - 1 : aluLatency + dm + late)
+			<< ", of a lw: " << (forwarding ? aluLatency + memoryDepth - 1 : aluLatency + memoryDepth + late) + memoryLatency - 1;
+		if (writebackInOrder && aluSkipsMemory)
+			out << "\nStalls before an alu instruction right behind a lw: " << memoryDepth + memoryLatency - 1
+				<< ", behind a sw: " << memoryDepth + memoryLatency - 2;
+		const char *inBTB = btbEntries > 0 ? " (0 when the branch target buffer has its target)" : "";
+		int targetBubbles = fetchDepth + min(targetStage, decodeDepth) - 1;
+		out << "\nBubbles after j: " << targetBubbles << inBTB << ", after beq/bne: "
+			<< (branchStage == DECODE ? fetchDepth + decodeDepth - 1 : fetchDepth + decodeDepth + aluLatency - 1);
+		if (predictor != NONE)
+			out << " when mispredicted, 0 when predicted not taken and " << targetBubbles << " when predicted taken" << inBTB;
+		out << '\n';
+	}
+};
+
+struct Model
+{
+	//an instruction in flight, seq is its position in the order of fetching
+	struct Slot
+	{
+		bool busy = false;
+		bool resolved = false; //for control instructions, once fetch may go on
+		long long seq = 0;
+		int pc = 0;
+		Instruction ins;
+		int writeReg = -1, value = 0; //the register it writes and what it writes into it
+		int address = 0; //word address of lw and sw
+		long long producer[3] = {-1, -1, -1}; //the instructions producing the registers it reads, [2] is the data of sw
+		long long leaveAt = 0; //it can not leave its stage before this cycle, set while a memory access is under way
+		bool taken = false, predicted = false, predictedTaken = false, mispredicted = false; //for beq and bne
+		int next = 0, fetchedNext = -1; //where the program goes after it and where fetch went, -1 while fetch waits
+		bool wrongPath = false; //fetched after fetch went the wrong way, it is never executed and goes once that is found out
+	};
+	//when the value of an instruction was computed and written back, LLONG_MAX until it happens
+	struct Result
+	{
+		long long seq = -1;
+		long long computed = LLONG_MAX, written = LLONG_MAX;
+	};
+
+	MIPS_Architecture *arch;
+	Config config;
+	int lastFetch, firstDecode, targetDecode, lastDecode, firstEX, lastEX, firstDM, lastDM, writeBack;
+	int hazardStage; //the ID stage instructions wait in until they can read their registers
+	vector<Slot> slots; //one per stage
+	vector<uint64_t> occupied; //a bit for each busy slot, so the stages holding bubbles are skipped
+	int inFlight = 0;
+	vector<Result> results; //a ring indexed by seq, it grows when an instruction still to write back would be overwritten
+	long long lastWriter[32];
+	long long nextSeq = 0, fetchFrom = 0;
+	bool controlPending = false, stopFetch = false;
+	unique_ptr<BranchPredictor> predictor; //nullptr without one and for the oracle
+	unique_ptr<BranchTargetBuffer> btb;
+	int wrongPath = -1; //where fetch goes on after it went the wrong way until that is found out, -1 on the right path
+	long long branches = 0, mispredictions = 0, squashed = 0;
+	long long takenControls = 0, btbRedirects = 0, misfetches = 0; //jumps and taken branches, those the BTB sent fetch after
+	//right away, and commands the BTB sent fetch the wrong way after
+	int registers[32]; //the values as executed, arch->registers only gets them at WB
+	int exitCode = MIPS_Architecture::SUCCESS;
+	bool memWrite = false; //the sw in the last DM stage this cycle
+	int memAddress = 0, memValue = 0;
+
+	Model(MIPS_Architecture *architecture, const Config &pipelineConfig)
+	{
+		arch = architecture;
+		config = pipelineConfig;
+		lastFetch = config.fetchDepth - 1;
+		firstDecode = lastFetch + 1;
+		lastDecode = firstDecode + config.decodeDepth - 1;
+		targetDecode = firstDecode + min(config.targetStage, config.decodeDepth) - 1;
+		hazardStage = (config.readStage && config.decodeDepth > 1) ? lastDecode - 1 : lastDecode;
+		firstEX = lastDecode + 1;
+		lastEX = firstEX + config.aluLatency - 1;
+		firstDM = lastEX + 1;
+		lastDM = firstDM + config.memoryDepth - 1;
+		writeBack = lastDM + 1;
+		slots.assign(config.stages(), Slot());
+		occupied.assign((slots.size() + 63) / 64, 0);
+		size_t ring = 1;
+		while (ring < 2 * slots.size())
+			ring <<= 1;
+		results.assign(ring, Result()); //enough unless the alu instructions retire past a lw waiting on memory
+		if (config.predictor != Config::NONE && config.predictor != Config::ORACLE)
+			predictor.reset(makeBranchPredictor(Config::predictorNames[config.predictor], config.predictorCounter,
+				config.predictorTableBits, config.predictorHistoryBits, config.tage));
+		if (config.btbEntries > 0)
+			btb.reset(new BranchTargetBuffer(config.btbEntries, config.btbWays, config.btbTagBits));
+	}
+
+	static bool isControl(const Instruction &ins)
+	{
+		return ins.type == 3;
+	}
+
+	//whether the value of producer can be used in the given cycle
+	bool ready(long long producer, long long cycle, bool forwarded)
+	{
+		if (producer < 0)
+			return true;
+		Result &r = results[producer & (results.size() - 1)];
+		if (r.seq != producer)
+			return true; //it wrote back and its entry went to a younger instruction
+		if (forwarded)
+			return r.computed < cycle;
+		return config.splitCycle ? r.written <= cycle : r.written < cycle;
+	}
+
+	bool operandsReady(Slot &x, long long cycle, bool forwarded)
+	{
+		return ready(x.producer[0], cycle, forwarded) && ready(x.producer[1], cycle, forwarded);
+	}
+
+	//the entry of seq in results. An entry is only given up once its instruction wrote back (or writes no register), so
+	//that ready() can never mistake one still in flight for one long gone: with a long memory latency any number of alu
+	//instructions can retire past a waiting lw. Doubling keeps the seqs in the ring apart, they differ modulo the old size
+	Result &claim(long long seq)
+	{
+		Result &old = results[seq & (results.size() - 1)];
+		if (old.seq < 0 || old.written != LLONG_MAX)
+			return old;
+		vector<Result> grown(results.size() * 2);
+		for (Result &r : results)
+			if (r.seq >= 0)
+				grown[r.seq & (grown.size() - 1)] = r;
+		results.swap(grown);
+		return claim(seq);
+	}
+
+	//-1 once x leaves the pipeline without going through WB
+	int nextStage(Slot &x, int stage)
+	{
+		int next = (stage == lastEX && config.aluSkipsMemory && x.ins.type != 2) ? writeBack : stage + 1;
+		if (next == writeBack && x.writeReg < 0 && config.aluSkipsMemory)
+			return -1; //it does not need the write port
+		return next;
+	}
+
+	void occupy(int stage)
+	{
+		slots[stage].busy = true;
+		occupied[stage >> 6] |= 1ULL << (stage & 63);
+		inFlight++;
+	}
+	void vacate(int stage)
+	{
+		slots[stage].busy = false;
+		occupied[stage >> 6] &= ~(1ULL << (stage & 63));
+		inFlight--;
+	}
+
+	//whether x, leaving hazardStage in cycle, would get to WB before an older lw or sw ahead of it, or together with an
+	//older lw when both write a register. A j never waits for it
+	bool overtakesMemory(Slot &x, long long cycle)
+	{
+		if (!config.writebackInOrder || !config.aluSkipsMemory || x.ins.type == 2 || x.ins.op == OP_J)
+			return false;
+		long long arrives = cycle + (lastDecode - hazardStage) + config.aluLatency;
+		for (int s = hazardStage + 1; s <= lastDM; ++s)
+		{
+			Slot &older = slots[s];
+			if (!older.busy || older.wrongPath || older.ins.type != 2)
+				continue;
+			//the stages after it have moved already this cycle, so one still in the last DM stage leaves next cycle at the soonest
+			long long memoryArrives = (s == lastDM) ? max(cycle + 1, older.leaveAt) : cycle + writeBack - s;
+			if (arrives < memoryArrives || (arrives == memoryArrives && x.writeReg >= 0 && older.writeReg >= 0))
+				return true;
+		}
+		return false;
+	}
+
+	//whether x can move from stage to to at the start of cycle
+	bool canLeave(Slot &x, int stage, int to, long long cycle)
+	{
+		if (slots[to].busy || cycle < x.leaveAt)
+			return false;
+		if (stage == lastDecode && isControl(x.ins) && !x.resolved && config.branchStage == Config::DECODE)
+			return false; //a branch resolving in ID waits there for its registers
+		if (stage == hazardStage)
+		{
+			//registers are read in the last ID cycle, forwarded values are taken in the first EX cycle, one cycle later
+			//when x goes on to a read stage
+			long long used = (config.forwarding ? cycle : cycle - 1) + (lastDecode - hazardStage);
+			if (!operandsReady(x, used, config.forwarding))
+				return false;
+			if (x.ins.op == OP_SW && !config.forwarding && !ready(x.producer[2], used, false))
+				return false;
+			if (overtakesMemory(x, cycle))
+				return false;
+		}
+		if (to == firstDM && x.ins.op == OP_SW && config.forwarding && !ready(x.producer[2], cycle, true))
+			return false;
+		if (to == writeBack && stage == lastEX && x.writeReg >= 0)
+			for (int s = firstDM; s <= lastDM; ++s)
+				if (slots[s].busy && slots[s].writeReg == x.writeReg)
+					return false; //an older lw still has to write it
+		return true;
+	}
+
+	//what happens in the first cycle of x in stage
+	void enter(Slot &x, int stage, long long cycle)
+	{
+		if (x.wrongPath)
+			return;
+		Result &r = results[x.seq & (results.size() - 1)];
+		if (stage == targetDecode)
+			decode(x, cycle);
+		if (stage == lastEX)
+		{
+			if (x.writeReg >= 0 && x.ins.op != OP_LW)
+				r.computed = cycle;
+			if (isControl(x.ins) && !x.resolved) //a j has resolved already
+				resolve(x, cycle);
+		}
+		if (stage == lastDM)
+		{
+			int latency = 1; //alu instructions going through DM only pass by
+			if (x.ins.type == 2 && !arch->caches.enabled)
+				latency = config.memoryLatency;
+			else if (x.ins.type == 2)
+				latency = (x.ins.op == OP_LW) ? arch->caches.read(x.address) : arch->caches.write(x.address);
+			x.leaveAt = cycle + latency;
+			if (x.ins.op == OP_LW)
+				r.computed = cycle + latency - 1;
+			if (x.ins.op == OP_SW)
+			{
+				memWrite = true;
+				memAddress = x.address;
+				memValue = x.value;
+			}
+		}
+		if (stage == writeBack && x.writeReg >= 0)
+		{
+			arch->registers[x.writeReg] = x.value;
+			r.written = cycle;
+		}
+	}
+
+	//the ID stage of target_stage knows what the command is, and where it goes if it is a j or a branch predicted taken.
+	//Fetch is sent there when it went elsewhere (the BTB had a wrong target, or had one for a command that is no jump) or
+	//was waiting to find out
+	void decode(Slot &x, long long cycle)
+	{
+		bool branch = (x.ins.op == OP_BEQ || x.ins.op == OP_BNE);
+		if (branch && !x.predicted)
+			return; //fetch waits for it to resolve
+		int decoded = (x.ins.op == OP_J || x.predictedTaken) ? x.ins.target : x.pc + 1;
+		if (x.ins.op == OP_J)
+		{
+			x.resolved = true;
+			if (btb)
+				btb->update(x.pc, x.ins.target);
+		}
+		else if (btb && !branch && x.fetchedNext != decoded)
+			btb->erase(x.pc);
+		if (x.fetchedNext == decoded)
+			return;
+		if (x.fetchedNext >= 0)
+		{
+			squash();
+			misfetches++;
+		}
+		redirect(x, decoded, cycle);
+	}
+
+	void resolve(Slot &x, long long cycle)
+	{
+		x.resolved = true;
+		if (predictor && x.predicted)
+			predictor->update(x.pc, x.taken);
+		if (btb && x.taken)
+			btb->update(x.pc, x.ins.target);
+		if (x.fetchedNext == x.next)
+			return; //fetch went the right way already
+		squash();
+		redirect(x, x.next, cycle);
+	}
+
+	//fetch goes on from pc after x in the next cycle, down the wrong path unless that is where the program goes
+	void redirect(Slot &x, int pc, long long cycle)
+	{
+		x.fetchedNext = pc;
+		controlPending = false;
+		fetchFrom = cycle + 1;
+		wrongPath = (pc == x.next) ? -1 : pc;
+	}
+
+	//where fetch goes on from after the command x that was just fetched, -1 if it has to wait. It goes on past a beq or
+	//bne predicted not taken, and when the branch target buffer has a target for the pc to that target if x is a j or a
+	//branch predicted taken (or is no jump at all, the BTB can not tell). Otherwise a j or a branch predicted taken waits
+	//for its target in the first ID stage, and without a predictor fetch waits for a branch to resolve
+	int predict(Slot &x)
+	{
+		bool branch = (x.ins.op == OP_BEQ || x.ins.op == OP_BNE);
+		if (branch && config.predictor != Config::NONE)
+		{
+			x.predicted = true;
+			x.predictedTaken = predictor ? predictor->predict(x.pc) : x.taken;
+			x.mispredicted = (x.predictedTaken != x.taken);
+			branches++;
+			mispredictions += x.mispredicted;
+		}
+		else if (branch)
+			return -1;
+		int target;
+		bool jumps = (x.ins.op == OP_J || x.predictedTaken);
+		takenControls += (x.ins.op == OP_J || x.taken);
+		if (btb && (jumps || !branch) && btb->lookup(x.pc, target))
+		{
+			btbRedirects += (jumps && target == x.ins.target && x.next == target);
+			return target;
+		}
+		return jumps ? -1 : x.pc + 1;
+	}
+
+	//throws away what was fetched down the wrong path, all of it is younger than the branch that resolved
+	void squash()
+	{
+		for (int s = 0; s < (int)slots.size(); ++s)
+			if (slots[s].busy && slots[s].wrongPath)
+			{
+				vacate(s);
+				squashed++;
+			}
+		wrongPath = -1;
+	}
+
+	//puts the command at wrongPath in the first stage without executing it
+	bool fetchWrongPath(long long cycle)
+	{
+		if (wrongPath >= (int)arch->program.size())
+			return false;
+		Slot &x = slots[0];
+		x = Slot();
+		x.ins = arch->program[wrongPath];
+		x.pc = wrongPath++;
+		x.seq = -1;
+		x.resolved = true; //a branch on the wrong path is never waited for
+		x.wrongPath = true;
+		x.leaveAt = cycle + arch->caches.fetch(x.pc);
+		occupy(0);
+		return true;
+	}
+
+	//executes the command at arch->PCnext and puts it in the first stage, returns false if there is nothing to fetch
+	bool fetch(long long cycle)
+	{
+		if (slots[0].busy || controlPending || cycle < fetchFrom || stopFetch || arch->fetchDone())
+			return false;
+		if (wrongPath >= 0)
+			return fetchWrongPath(cycle);
+		int pc = arch->PCnext;
+		Slot &x = slots[0];
+		x.ins = arch->program[pc];
+		x.pc = pc;
+		x.resolved = false;
+		x.taken = x.predicted = x.predictedTaken = x.mispredicted = x.wrongPath = false;
+		x.writeReg = -1;
+		x.producer[0] = x.producer[1] = x.producer[2] = -1;
+		int *R = registers, next = pc + 1;
+		const Instruction &ins = x.ins;
+		switch (ins.op)
+		{
+		case OP_ADD: x.value = R[ins.r[1]] + R[ins.r[2]]; break;
+		case OP_SUB: x.value = R[ins.r[1]] - R[ins.r[2]]; break;
+		case OP_MUL: x.value = R[ins.r[1]] * R[ins.r[2]]; break;
+		case OP_AND: x.value = R[ins.r[1]] & R[ins.r[2]]; break;
+		case OP_OR: x.value = R[ins.r[1]] | R[ins.r[2]]; break;
+		case OP_SLT: x.value = R[ins.r[1]] < R[ins.r[2]]; break;
+		case OP_ADDI: x.value = R[ins.r[1]] + ins.imm; break;
+		case OP_ANDI: x.value = R[ins.r[1]] & ins.imm; break;
+		case OP_ORI: x.value = R[ins.r[1]] | ins.imm; break;
+		case OP_SRL: x.value = R[ins.r[1]] >> ins.imm; break;
+		case OP_SLL: x.value = R[ins.r[1]] << ins.imm; break;
+		case OP_LW:
+		case OP_SW:
+		{
+			uint32_t address = (uint32_t)R[ins.r[1]] + (uint32_t)ins.imm; //the same checks as the functional model
+			if (address % 4 != 0 || address >= arch->addressLimit)
+			{
+				exitCode = MIPS_Architecture::INVALID_ADDRESS;
+				arch->PCcurr = pc;
+				stopFetch = true; //what is in flight still drains
+				return false;
+			}
+			x.address = address / 4;
+			if (ins.op == OP_LW)
+				x.value = arch->data.read(x.address);
+			else
+			{
+				x.value = R[ins.r[0]];
+				arch->data.write(x.address, x.value);
+			}
+			break;
+		}
+		case OP_BEQ:
+		case OP_BNE:
+			x.taken = (R[ins.r[0]] == R[ins.r[1]]) == (ins.op == OP_BEQ);
+			next = x.taken ? ins.target : pc + 1;
+			break;
+		case OP_J: next = ins.target; break;
+		}
+		//the registers it reads and writes
+		if (ins.type == 0)
+			x.producer[0] = lastWriter[ins.r[1]], x.producer[1] = lastWriter[ins.r[2]];
+		else if (ins.type == 1 || ins.type == 2)
+			x.producer[1] = lastWriter[ins.r[1]];
+		else if (ins.op != OP_J)
+			x.producer[0] = lastWriter[ins.r[0]], x.producer[1] = lastWriter[ins.r[1]];
+		if (ins.op == OP_SW)
+			x.producer[2] = lastWriter[ins.r[0]];
+		else if (ins.type <= 2)
+			x.writeReg = ins.r[0];
+
+		arch->PCcurr = pc;
+		arch->countFetch();
+		arch->PCnext = next;
+		x.seq = nextSeq++;
+		x.leaveAt = cycle + arch->caches.fetch(pc); //it waits in the first IF stage for a miss
+		occupy(0);
+		//an instruction writing no register is never a producer, its entry is free to be taken at once
+		long long never = (x.writeReg >= 0) ? LLONG_MAX : cycle;
+		claim(x.seq) = Result{x.seq, never, never};
+		if (x.writeReg >= 0)
+		{
+			registers[x.writeReg] = x.value;
+			lastWriter[x.writeReg] = x.seq;
+		}
+		x.next = next;
+		x.fetchedNext = predict(x);
+		if (x.fetchedNext < 0)
+			controlPending = true;
+		else if (x.fetchedNext != next)
+			wrongPath = x.fetchedNext;
+		return true;
+	}
+
+	void printStages()
+	{
+		for (int s = 0; s < (int)slots.size(); ++s)
+		{
+			cout << '|' << config.stageName(s) << "|=> ";
+			if (slots[s].busy)
+				cout << (slots[s].wrongPath ? "?" : "") << slots[s].pc << ' ' << opcodeName(slots[s].ins.op) << ' ';
+			else
+				cout << "- ";
+		}
+	}
+
+	//the first cycle after cycle in which something that is only waiting for time to pass can go on
+	long long nextEvent(long long cycle)
+	{
+		long long wake = LLONG_MAX;
+		auto consider = [&](long long at)
+		{
+			if (at > cycle && at < wake)
+				wake = at;
+		};
+		consider(fetchFrom);
+		for (int s = 0; s < (int)slots.size(); ++s)
+		{
+			if (!slots[s].busy)
+				continue;
+			consider(slots[s].leaveAt);
+			for (long long producer : slots[s].producer)
+			{
+				if (producer < 0)
+					continue;
+				Result &r = results[producer & (results.size() - 1)];
+				if (r.seq != producer)
+					continue;
+				if (r.computed != LLONG_MAX)
+					consider(r.computed), consider(r.computed + 1);
+				if (r.written != LLONG_MAX)
+					consider(r.written), consider(r.written + 1), consider(r.written + 2);
+			}
+		}
+		return (wake == LLONG_MAX) ? cycle + 1 : wake;
+	}
+
+	//the output of a cycle
+	void report(int clockCycle)
+	{
+		if (arch->outputFormat == 0)
+			printStages();
+		if (arch->outputFormat != 2)
+		{
+			arch->printRegisters(clockCycle);
+			if (memWrite)
+				cout << 1 << " " << memAddress << " " << memValue;
+			else
+				cout << 0;
+			cout << endl;
+		}
+		if (arch->trace)
+			arch->trace->cycle(arch->registers, memWrite, memAddress, memValue);
+	}
+
+	//runs from the current state of arch until the pipeline drains, returns the number of cycles it took
+	int run()
+	{
+		memcpy(registers, arch->registers, sizeof(registers));
+		for (int reg = 0; reg < 32; ++reg)
+			lastWriter[reg] = -1;
+		int clockCycles = 0;
+		while (true)
+		{
+			long long cycle = clockCycles + 1;
+			memWrite = false;
+			bool active = slots[writeBack].busy; //whether anything changes this cycle
+			bool passing = false; //an instruction that writes no register goes by WB this cycle without taking the port
+			if (active)
+				vacate(writeBack); //what was in WB retired at the end of the last cycle
+			for (int word = occupied.size() - 1; word >= 0; --word) //the busy stages from the last to the first
+				for (uint64_t busy = occupied[word]; busy; )
+				{
+					int bit = 63 - __builtin_clzll(busy);
+					busy &= ~(1ULL << bit);
+					int s = word * 64 + bit;
+					Slot &x = slots[s];
+					if (!x.busy)
+						continue; //squashed by a branch resolving ahead of it
+					int to = nextStage(x, s);
+					if (to < 0 && cycle >= x.leaveAt) //a sw still waits for its memory access
+					{
+						vacate(s);
+						active = passing = true;
+					}
+					else if (to >= 0 && canLeave(x, s, to, cycle))
+					{
+						slots[to] = x;
+						occupy(to);
+						vacate(s);
+						enter(slots[to], to, cycle);
+						active = true;
+					}
+				}
+			if (fetch(cycle))
+				active = true;
+			if (inFlight == 0 && !passing)
+				break;
+			Slot &decoded = slots[lastDecode]; //a branch resolving in ID waits there for its registers
+			if (decoded.busy && isControl(decoded.ins) && !decoded.resolved && config.branchStage == Config::DECODE &&
+				operandsReady(decoded, cycle, config.forwarding))
+			{
+				resolve(decoded, cycle);
+				active = true;
+			}
+
+			clockCycles++;
+			arch->timeFetches(clockCycles);
+			report(clockCycles);
+			if (active)
+				continue;
+			//nothing moved, and nothing will until something it waits on is ready, so the cycles before that are all
+			//the same as this one
+			long long wake = nextEvent(cycle);
+			if (arch->outputFormat == 2 && !arch->trace)
+			{
+				clockCycles = wake - 1;
+				arch->timeFetches(clockCycles); //nothing is fetched in between, so only the last of them counts
+			}
+			else
+				while (clockCycles + 1 < wake)
+				{
+					clockCycles++;
+					arch->timeFetches(clockCycles);
+					report(clockCycles);
+				}
+		}
+		return clockCycles;
+	}
+};
+
+//runs the pipeline described by config from the current state of arch until it drains and returns the number of cycles
+//it took, exitCode is set if an instruction used an invalid address (fetching stops there)
+int RunPipeline(MIPS_Architecture *arch, const Config &config, int &exitCode)
+{
+	Model model(arch, config);
+	int clockCycles = model.run();
+	exitCode = model.exitCode;
+	return clockCycles;
+}
+
+void ExecutePipelined(MIPS_Architecture *arch, const Config &config)
+{
+	if (arch->decodeError != arch->SUCCESS)
+	{
+		arch->handleExit(arch->decodeError, 0);
+		return;
+	} //a command could not be decoded
+	if ((long long)arch->commands.size() >= arch->addressLimit / 4)
+	{
+		arch->handleExit(arch->MEMORY_ERROR, 0);
+		return;
+	} //memory error
+	if (arch->outputFormat == 0)
+		config.describe(cout);
+	//the cycles of the same run on another config, to tell what prediction saves
+	auto cyclesOn = [arch](const Config &other)
+	{
+		MIPS_Architecture copy(*arch);
+		copy.outputFormat = 2;
+		copy.trace = nullptr;
+		int exitCode;
+		return RunPipeline(&copy, other, exitCode);
+	};
+	Config stalling = config, withoutBTB = config;
+	stalling.predictor = Config::NONE;
+	stalling.btbEntries = withoutBTB.btbEntries = 0;
+	bool predicts = (config.predictor != Config::NONE || config.btbEntries > 0);
+	long long stallingCycles = predicts ? cyclesOn(stalling) : -1;
+	long long withoutBTBCycles = (config.btbEntries > 0 && config.predictor != Config::NONE) ? cyclesOn(withoutBTB) : stallingCycles;
+
+	Model model(arch, config);
+	int clockCycles = model.run();
+	arch->handleExit((MIPS_Architecture::exit_code)model.exitCode, clockCycles);
+	if (!predicts)
+		return;
+	cout << '\n';
+	if (config.predictor != Config::NONE)
+		cout << "Branch predictor " << Config::predictorNames[config.predictor] << ": " << model.branches << " branches, "
+			<< model.mispredictions << " mispredicted, accuracy "
+			<< (model.branches ? 100.0 * (model.branches - model.mispredictions) / model.branches : 100.0) << "%\n";
+	if (model.btb)
+		cout << "Branch target buffer (" << config.btbEntries << " entries, " << config.btbWays << " way, " << config.btbTagBits
+			<< " tag bits): " << model.btb->hits << " hits in " << model.btb->lookups << " lookups, fetch followed "
+			<< model.btbRedirects << " of " << model.takenControls << " jumps and taken branches right away ("
+			<< (model.takenControls ? 100.0 * model.btbRedirects / model.takenControls : 0.0) << "%), "
+			<< model.misfetches << " times it sent fetch the wrong way\n";
+	cout << model.squashed << " wrong path commands squashed\n";
+	cout << "Cycles: " << clockCycles << ", without prediction " << stallingCycles << " (saved " << stallingCycles - clockCycles << ")";
+	if (model.btb)
+		cout << ", without the branch target buffer " << withoutBTBCycles << " (saved " << withoutBTBCycles - clockCycles << ")";
+	cout << '\n';
+}
+
+} //namespace ParametricStage
+
+#endif
@@ -0,0 +1,67 @@
+#include<MIPS_Processor.hpp>
+#include<FunctionalModel.hpp>
+#include<Sampling.hpp>
+#include<5stage.hpp>
+#include<5stage_bypass.hpp>
+#include<79stage.hpp>
+#include<RunOptions.hpp>
+using namespace std;
+
+//runs the program as a sampled simulation on one of the pipelines and reports the estimated CPI and number of cycles
+int main(int argc, char *argv[])
+{
+	RunOptions options;
+	if (argc < 2 || !options.parse(argc - 1, argv + 1) || (options.rest.size() != 0 && options.rest.size() != 3) || !options.trace.empty())
+	{
+		std::cerr << "Required arguments: model file_name [period warmup window]\n./samplingFinal <5stage|5stage_bypass|79stage> <file name> [period warmup window] " << RunOptions::usage << "\n";
+		return 0;
+	}
+	string modelName = argv[1];
+	int (*runPipeline)(MIPS_Architecture *);
+	if (modelName == "5stage")
+		runPipeline = FiveStage::RunPipeline;
+	else if (modelName == "5stage_bypass")
+		runPipeline = FiveStageBypass::RunPipeline;
+	else if (modelName == "79stage")
+		runPipeline = SevenNineStage::RunPipeline;
+	else
+	{
+		std::cerr << "Unknown model " << modelName << ", expected 5stage, 5stage_bypass or 79stage\n";
+		return 0;
+	}
+	long long period = 100000, warmup = 100, window = 1000; //in instructions
+	if (options.rest.size() == 3)
+	{
+		period = atoll(options.rest[0].c_str()); warmup = atoll(options.rest[1].c_str()); window = atoll(options.rest[2].c_str());
+		if (window <= 0 || warmup < 0 || period < warmup + window)
+		{
+			std::cerr << "Need window > 0, warmup >= 0 and period >= warmup + window\n";
+			return 0;
+		}
+	}
+	MIPS_Architecture *mips = options.load();
+	if (!mips)
+		return 0;
+	if (mips->decodeError != mips->SUCCESS)
+	{
+		mips->handleExit(mips->decodeError, 0);
+		return 0;
+	}
+
+	SamplingResult result = RunSampled(mips, runPipeline, period, warmup, window);
+	mips->handleExit((MIPS_Architecture::exit_code)result.exitCode, result.cycles());
+	cout << "\nSampled simulation on " << modelName << ", period " << period << ", warmup " << warmup << ", window " << window << '\n';
+	cout << "Instructions executed: " << result.instructions << '\n';
+	cout << "Samples: " << result.samples << '\n';
+	if (result.samples < 2)
+	{
+		cout << "Too few samples for a confidence interval, use a smaller period\n";
+		if (result.samples == 1)
+			cout << "Estimated CPI: " << result.cpi << "\nEstimated cycles: " << result.cycles() << '\n';
+		return 0;
+	}
+	cout << "Estimated CPI: " << result.cpi << " +- " << result.cpiError << " (99.7% confidence)\n";
+	cout << "Estimated cycles: " << result.cycles() << " +- " << llround(result.cyclesError()) << '\n';
+	cout << "Coefficient of variation of the samples: " << result.variation << ", samples needed for +-3%: " << result.samplesNeeded(0.03) << '\n';
+	return 0;
+}
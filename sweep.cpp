@@ -0,0 +1,130 @@
+#include<Sweep.hpp>
+#include<sstream>
+using namespace std;
+
+static const char *usage = "./sweepFinal [--models <5stage,79stage,config>] [--forwarding <off,on>] [--predictors <saturating,bhr,gshare,...>] "
+	"[--counters <0,1,2,3>] [--table-bits <14,...>] [--history-bits <12,...>] [--threads <n>] [--out <file>] <file name>...";
+
+vector<string> split(const string &list)
+{
+	vector<string> items;
+	stringstream in(list);
+	string item;
+	while (getline(in, item, ','))
+		if (item != "")
+			items.push_back(item);
+	return items;
+}
+
+//false if some item is not a number in [low, high]
+bool numbers(const string &list, int low, int high, vector<int> &values)
+{
+	values.clear();
+	for (string &item : split(list))
+	{
+		if (item.find_first_not_of("0123456789") != string::npos || item.size() > 9)
+			return false;
+		values.push_back(stoi(item));
+		if (values.back() < low || values.back() > high)
+			return false;
+	}
+	return !values.empty();
+}
+
+//runs every program on every combination of the options on all the cores and writes one table of the results,
+//models are 5stage, 79stage or config files of the parametric model (see pipeline.cfg)
+int main(int argc, char *argv[])
+{
+	vector<string> models = {"5stage", "79stage"}, forwarding = {"off", "on"}, predictors;
+	vector<int> counters = {0, 1, 2, 3}, tableBits = {14}, historyBits = {12};
+	int threads = 0;
+	string out;
+	Sweep::Grid grid;
+	bool argsOk = true;
+	for (int i = 1; i < argc && argsOk; ++i)
+	{
+		string arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+		if (arg == "--models" && hasValue)
+			models = split(argv[++i]);
+		else if (arg == "--forwarding" && hasValue)
+			forwarding = split(argv[++i]);
+		else if (arg == "--predictors" && hasValue)
+			predictors = split(argv[++i]);
+		else if (arg == "--counters" && hasValue)
+			argsOk = numbers(argv[++i], 0, 3, counters);
+		else if (arg == "--table-bits" && hasValue)
+			argsOk = numbers(argv[++i], 1, 24, tableBits);
+		else if (arg == "--history-bits" && hasValue)
+			argsOk = numbers(argv[++i], 1, 1024, historyBits);
+		else if (arg == "--threads" && hasValue)
+		{
+			vector<int> n;
+			argsOk = numbers(argv[++i], 1, 4096, n) && n.size() == 1;
+			threads = argsOk ? n[0] : 0;
+		}
+		else if (arg == "--out" && hasValue)
+			out = argv[++i];
+		else if (arg.substr(0, 2) == "--")
+			argsOk = false;
+		else
+			grid.programs.push_back(arg);
+	}
+	for (string &f : forwarding)
+		argsOk = argsOk && (f == "on" || f == "off");
+	for (string &p : predictors)
+		argsOk = argsOk && unique_ptr<BranchPredictor>(makeBranchPredictor(p, 0, 1, 1));
+	if (!argsOk || grid.programs.empty() || models.empty() || forwarding.empty())
+	{
+		std::cerr << "Required argument: file_name\n" << usage << "\n";
+		return 0;
+	}
+
+	for (string &model : models)
+		for (string &f : forwarding)
+		{
+			Sweep::PipelinePoint point;
+			if (Sweep::makePipeline(model, f == "on", point))
+				grid.pipelines.push_back(point);
+			else if (model == "79stage")
+				std::cerr << "79stage has no forwarding, skipping it with forwarding on\n";
+			else
+				return 0; //the config said what is wrong with it
+		}
+	for (string &type : predictors)
+		for (size_t c = 0; c < (Sweep::PredictorPoint{type}.hasCounters() ? counters.size() : 1); ++c)
+		{
+			Sweep::PredictorPoint point = {type, counters[c]};
+			for (size_t i = 0; i < (point.hasTable() ? tableBits.size() : 1); ++i)
+				for (size_t j = 0; j < (point.hasHistory() ? historyBits.size() : 1); ++j)
+				{
+					point.tableBits = tableBits[i];
+					point.historyBits = historyBits[j];
+					if (point.historyBits > point.maxHistoryBits()) //only the perceptron takes more than 24
+						continue;
+					if (!point.fits())
+					{
+						std::cerr << "A perceptron of 2^" << point.tableBits << " rows of " << point.historyBits
+							<< " history bits takes more than " << (PerceptronBranchPredictor::MAX_WEIGHTS >> 20) << "MB of weights\n";
+						return 0;
+					}
+					grid.predictors.push_back(point);
+				}
+		}
+
+	ThreadPool pool(threads);
+	grid.run(pool);
+	if (out == "")
+		grid.write(cout);
+	else
+	{
+		ofstream file(out);
+		if (!file.is_open())
+		{
+			std::cerr << "Could not write " << out << '\n';
+			return 0;
+		}
+		grid.write(file);
+	}
+	return 0;
+}
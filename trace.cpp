@@ -0,0 +1,53 @@
+#include<Trace.hpp>
+#include<cstdlib>
+#include<algorithm>
+using namespace std;
+
+//turns a binary trace back into the text the pipelines print with --format 1, byte for byte. With first and last only
+//those cycles are printed (counting from 1), seeking straight to first through the keyframe index
+int main(int argc, char *argv[])
+{
+	if (argc != 2 && argc != 4)
+	{
+		std::cerr << "Required argument: trace_name\n./traceFinal <trace name> [first last]\n";
+		return 0;
+	}
+	Trace::Reader trace;
+	if (!trace.open(argv[1]))
+		return 0;
+	long long first = 1, last = trace.cycles;
+	if (argc == 4)
+	{
+		first = atoll(argv[2]);
+		last = min(atoll(argv[3]), trace.cycles);
+		if (first < 1 || first > last)
+		{
+			std::cerr << "The trace has cycles 1 to " << trace.cycles << '\n';
+			return 0;
+		}
+	}
+	if (!trace.seek(first - 1))
+	{
+		std::cerr << "Trace " << argv[1] << " is damaged\n";
+		return 0;
+	}
+	string out;
+	while (trace.cycle < last)
+	{
+		if (!trace.next())
+		{
+			std::cerr << "Trace " << argv[1] << " is damaged\n";
+			return 0;
+		}
+		Trace::formatCycle(out, trace.registers, trace.memWrite, trace.address, trace.value);
+		if (out.size() >= (1 << 16))
+		{
+			cout << out;
+			out.clear();
+		}
+	}
+	if (argc == 2)
+		out += '\n'; //the one that ends every run
+	cout << out;
+	return 0;
+}